@@ -21,7 +21,8 @@ void printHelp() {
     std::cout << "  paa info <paa_file>                 Show information about a PAA file." << std::endl;
 #ifdef GRAD_AFF_USE_OIIO
     std::cout << "  paa to-png <paa_file> <out_png>     Convert a PAA file to a PNG image." << std::endl;
-    std::cout << "  paa from-png <in_png> <out_paa>     Convert a PNG image to a PAA file." << std::endl;
+    std::cout << "  paa from-png <in_png> <out_paa> [--quality fast|normal|high]" << std::endl;
+    std::cout << "                                      Convert a PNG image to a PAA file, DXT quality defaults to high." << std::endl;
 #endif
     std::cout << "  p3d info <p3d_file>                 Show information about a P3D model file." << std::endl;
     std::cout << "  wrp info <wrp_file>                 Show information about a WRP file." << std::endl;
@@ -61,30 +62,11 @@ void handlePbo(const std::vector<std::string>& args) {
                 return;
             }
             fs::path outDir = args[3];
-            pbo.readPbo(true); // Read with data
+            pbo.readPbo(false); // Entries are unpacked on demand while extracting
 
             std::cout << "Extracting " << pbo.entries.size() << " files to " << fs::absolute(outDir) << "..." << std::endl;
 
-            for (const auto& entryPair : pbo.entries) {
-                const auto& entry = entryPair.second;
-                std::string entryPathStr = entry->filename.string();
-                std::replace(entryPathStr.begin(), entryPathStr.end(), '\\', fs::path::preferred_separator);
-
-                fs::path finalOutPath = outDir / entryPathStr;
-                fs::path finalOutDir = finalOutPath.parent_path();
-
-                if (!finalOutDir.empty() && !fs::exists(finalOutDir)) {
-                    fs::create_directories(finalOutDir);
-                }
-
-                std::ofstream ofs(finalOutPath, std::ios::binary);
-                if (ofs) {
-                    ofs.write(reinterpret_cast<const char*>(entry->data.data()), entry->data.size());
-                    ofs.close();
-                } else {
-                    std::cerr << "Error: Could not open file for writing: " << finalOutPath << std::endl;
-                }
-            }
+            pbo.extractPbo(outDir);
 
             std::cout << "Successfully extracted " << pbo.entries.size() << " files." << std::endl;
 
@@ -139,8 +121,22 @@ void handlePaa(const std::vector<std::string>& args) {
                 return;
             }
             fs::path outPaa = args[3];
+            auto quality = grad_aff::Paa::DxtQuality::High;
+            if (args.size() >= 6 && args[4] == "--quality") {
+                if (args[5] == "fast") {
+                    quality = grad_aff::Paa::DxtQuality::Fast;
+                } else if (args[5] == "normal") {
+                    quality = grad_aff::Paa::DxtQuality::Normal;
+                } else if (args[5] != "high") {
+                    std::cerr << "Error: Unknown quality '" << args[5] << "'." << std::endl;
+                    return;
+                }
+            } else if (args.size() > 4) {
+                std::cerr << "Error: Unknown option '" << args[4] << "'." << std::endl;
+                return;
+            }
             paa.readImage(inputFile.string());
-            paa.writePaa(outPaa.string());
+            paa.writePaa(outPaa.string(), grad_aff::Paa::TypeOfPaX::UNKNOWN, quality);
             std::cout << "Successfully converted " << inputFile.filename() << " to " << outPaa.filename() << std::endl;
         }
 #endif
@@ -214,7 +210,7 @@ void handleWrp(const std::vector<std::string>& args) {
     try {
         if (action == "info") {
             grad_aff::Wrp wrp(wrpFile.string());
-            wrp.readWrp();
+            wrp.readWrp(grad_aff::Wrp::SectionObjects);
             std::cout << "WRP Info: " << wrp.wrpName << std::endl;
             std::cout << "  Version: " << wrp.wrpVersion << std::endl;
             std::cout << "  Map Size: " << wrp.mapSizeX << "x" << wrp.mapSizeY << std::endl;
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "grad_aff.h"
+#include "Span.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Values are copied as stored, the file formats are all little endian
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "grad_aff needs a little endian host"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace grad_aff {
+
+    // Bounds checked little endian reader over a contiguous buffer, either a mapped file or an owned vector.
+    // Copies share the buffer but keep their own position.
+    class GRAD_AFF_API BinaryReader {
+        ByteSpan buffer = {};
+        size_t position = 0;
+        // keeps the memory behind buffer alive (vector, mapping, ...)
+        std::shared_ptr<const void> owner = {};
+
+        void require(size_t size) const {
+            if (size > buffer.size() - position) {
+                throw std::out_of_range("Read past the end of the buffer");
+            }
+        }
+    public:
+        BinaryReader() = default;
+        BinaryReader(ByteSpan buffer, std::shared_ptr<const void> owner = {});
+        BinaryReader(std::vector<uint8_t> data);
+
+        // Maps the file, files that can't be opened give an empty reader so parsers report them on the first read
+        static BinaryReader fromFile(const fs::path& path);
+
+        template<typename T>
+        T read() {
+            auto t = peek<T>();
+            position += sizeof(T);
+            return t;
+        }
+
+        template<typename T>
+        T peek() const {
+            static_assert(std::is_trivially_copyable<T>::value, "BinaryReader can only read trivially copyable types");
+            if constexpr (std::is_same<T, bool>::value) {
+                return peek<uint8_t>() != 0;
+            }
+            else {
+                require(sizeof(T));
+                T t;
+                std::memcpy(&t, buffer.data() + position, sizeof(T));
+                return t;
+            }
+        }
+
+        // count consecutive values in a single copy
+        template<typename T>
+        std::vector<T> readArray(size_t count) {
+            static_assert(std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value, "BinaryReader can only bulk read trivially copyable types");
+            if (count > remaining() / sizeof(T)) {
+                throw std::out_of_range("Read past the end of the buffer");
+            }
+            std::vector<T> result(count);
+            readInto(result.data(), count * sizeof(T));
+            return result;
+        }
+
+        void readInto(void* destination, size_t size) {
+            require(size);
+            if (size > 0) {
+                std::memcpy(destination, buffer.data() + position, size);
+            }
+            position += size;
+        }
+
+        // the view stays valid as long as any reader on this buffer does
+        ByteSpan readView(size_t size) {
+            require(size);
+            auto view = ByteSpan(buffer.data() + position, size);
+            position += size;
+            return view;
+        }
+
+        void skip(size_t size) {
+            require(size);
+            position += size;
+        }
+
+        void seek(size_t newPosition);
+
+        size_t tell() const noexcept { return position; }
+        size_t size() const noexcept { return buffer.size(); }
+        size_t remaining() const noexcept { return buffer.size() - position; }
+        bool eof() const noexcept { return position >= buffer.size(); }
+
+        ByteSpan getBuffer() const noexcept { return buffer; }
+        ByteSpan getRemaining() const noexcept { return ByteSpan(buffer.data() + position, buffer.size() - position); }
+        const std::shared_ptr<const void>& getOwner() const noexcept { return owner; }
+    };
+}
@@ -1,20 +1,39 @@
 #pragma once
 
+#include "grad_aff.h"
+#include "Span.h"
+
+#include <array>
 #include <vector>
 #include <memory>
 
 namespace grad_aff {
 
-    class GridBlockTree {
+    // Quadtree of a WRP grid block, every packet splits its area 4x4.
+    // All packets and leaves of a tree live in two flat arrays, nodes[0] is the root packet.
+    // Child i of a packet covers column i % 4 and row i / 4 of its area.
+    class GRAD_AFF_API GridBlockTree {
     public:
-        GridBlockTree();
-        GridBlockTree(bool isLeaf, std::vector<uint8_t> data);
-        std::vector<std::shared_ptr<GridBlockTree>> children;
-        bool isLeaf;
+        // a child slot with this bit set is an index into the leaves, otherwise into nodes
+        static constexpr uint32_t leafFlag = 0x80000000;
+
+        std::vector<std::array<uint32_t, 16>> nodes = {};
+        // leafSize bytes per leaf
+        std::vector<uint8_t> leafData = {};
+        uint32_t leafSize = 0;
+        // packet levels from the root to the finest leaves, lookups cover 4^levels x 4^levels leaves
+        uint32_t levels = 0;
 
-        std::vector<uint8_t> data;
+        // trees without nodes are grid blocks that aren't present in the file
+        bool empty() const noexcept;
+        void clear();
 
-        void addChild(std::shared_ptr<GridBlockTree> gridBlockTree);
-        void removeChild(int index);
+        size_t leafCount() const noexcept;
+        ByteSpan getLeaf(size_t leafIndex) const;
+        // leaf covering x/y in units of the finest level, empty if x/y are outside or deeper than levels.
+        // Descends the flat nodes, at most levels lookups
+        ByteSpan getLeaf(uint32_t x, uint32_t y) const;
+        // first (up to) 4 bytes of the leaf at x/y, 0 when there is none
+        uint32_t getValue(uint32_t x, uint32_t y) const;
     };
-};
\ No newline at end of file
+};
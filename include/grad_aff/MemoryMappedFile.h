@@ -0,0 +1,32 @@
+#pragma once
+
+#include "grad_aff.h"
+#include "Span.h"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace grad_aff {
+
+    // Read-only mapping of a whole file, unmapped on destruction
+    class GRAD_AFF_API MemoryMappedFile {
+        const uint8_t* mappedData = nullptr;
+        size_t mappedSize = 0;
+#if defined(_WIN32) || defined(__CYGWIN__)
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    public:
+        MemoryMappedFile(const fs::path& path);
+        ~MemoryMappedFile();
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        const uint8_t* data() const noexcept;
+        size_t size() const noexcept;
+        ByteSpan span() const noexcept;
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#ifdef GRAD_AFF_USE_THREAD_POOL
+    #include "ThreadPool.h"
+#endif
+
+namespace grad_aff {
+
+    // Calls f(i) for every i in [begin, end) on the shared ThreadPool, the calling thread takes indices as well.
+    // GRAD_AFF_ENABLE_PARALLELISM defines GRAD_AFF_USE_THREAD_POOL, without it the loop runs serially.
+    // Nested calls queue on the same workers, so parallel loops inside parallel loops don't start extra threads.
+    // The first exception thrown by f is rethrown on the calling thread.
+    template<typename Function>
+    void parallelFor(size_t begin, size_t end, Function&& f)
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        std::exception_ptr exception = nullptr;
+        std::mutex exceptionMutex;
+        auto guarded = [&f, &exception, &exceptionMutex](size_t i) {
+            try {
+                f(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+        };
+
+#ifdef GRAD_AFF_USE_THREAD_POOL
+        auto& pool = ThreadPool::global();
+        // helpers that only start after the loop finished find no index left and never touch this frame,
+        // so the loop is done once every index ran
+        struct Range {
+            std::atomic<size_t> next;
+            std::atomic<size_t> remaining;
+            size_t end;
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+        auto range = std::make_shared<Range>();
+        range->next = begin;
+        range->remaining = end - begin;
+        range->end = end;
+
+        auto work = [range, &guarded]() {
+            for (auto i = range->next++; i < range->end; i = range->next++) {
+                guarded(i);
+                if (--range->remaining == 0) {
+                    std::lock_guard<std::mutex> lock(range->mutex);
+                    range->done.notify_all();
+                }
+            }
+        };
+        auto helpers = std::min(pool.size(), end - begin - 1);
+        for (size_t h = 0; h < helpers; h++) {
+            pool.submit(work);
+        }
+        work();
+        // run other queued tasks while the helpers finish their last indices, sleep once there are none.
+        // Every index is taken by a running thread at this point, so no queued task is needed to finish.
+        while (range->remaining > 0) {
+            if (!pool.runPendingTask()) {
+                std::unique_lock<std::mutex> lock(range->mutex);
+                range->done.wait(lock, [&range]() { return range->remaining == 0; });
+            }
+        }
+#else
+        for (size_t i = begin; i < end; i++) {
+            guarded(i);
+        }
+#endif
+
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
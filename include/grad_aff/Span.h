@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace grad_aff {
+
+    // Non-owning view over contiguous memory, stand-in for C++20 std::span
+    template<typename T>
+    class Span {
+        T* ptr = nullptr;
+        size_t count = 0;
+    public:
+        Span() = default;
+        Span(T* data, size_t size) : ptr(data), count(size) {}
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+        Span(std::vector<U>& vec) : ptr(vec.data()), count(vec.size()) {}
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible_v<const U(*)[], T(*)[]>>>
+        Span(const std::vector<U>& vec) : ptr(vec.data()), count(vec.size()) {}
+
+        T* data() const noexcept { return ptr; }
+        size_t size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+
+        T* begin() const noexcept { return ptr; }
+        T* end() const noexcept { return ptr + count; }
+
+        T& operator[](size_t index) const { return ptr[index]; }
+
+        Span subspan(size_t offset, size_t length) const {
+            if (offset > count || length > count - offset) {
+                throw std::out_of_range("Span access out of range");
+            }
+            return Span(ptr + offset, length);
+        }
+
+        std::vector<std::remove_const_t<T>> toVector() const {
+            return std::vector<std::remove_const_t<T>>(ptr, ptr + count);
+        }
+    };
+
+    using ByteSpan = Span<const uint8_t>;
+}
@@ -3,6 +3,8 @@
 #include "a3lzo.h"
 
 #include "Types.h"
+#include "Span.h"
+#include "BinaryReader.h"
 
 #include <istream>
 #include <ostream>
@@ -25,6 +27,10 @@ namespace grad_aff {
     
     uint32_t readBytesAsArmaUShort(std::istream& is);
 
+    // Up to maxSize bytes from the current position, read into storage.
+    // The position afterwards is unspecified.
+    ByteSpan readSpan(std::istream& is, std::vector<uint8_t>& storage, size_t maxSize);
+
     template<typename T>
     T peekBytes(std::istream& is);
 
@@ -58,6 +64,64 @@ namespace grad_aff {
     template<typename T>
     std::vector<T> readCompressedFillArray(std::istream& is, bool useCompressionFlag);
 
+    // Read from a BinaryReader, same formats as above
+    template<typename T>
+    inline T readBytes(BinaryReader& reader) {
+        return reader.read<T>();
+    }
+
+    template<typename T>
+    inline T peekBytes(BinaryReader& reader) {
+        return reader.peek<T>();
+    }
+
+    template<typename T>
+    inline std::vector<T> readArray(BinaryReader& reader, size_t count) {
+        return reader.readArray<T>(count);
+    }
+
+    uint32_t readBytesAsArmaUShort(BinaryReader& reader);
+
+    inline XYZTriplet readXYZTriplet(BinaryReader& reader) {
+        return reader.read<XYZTriplet>();
+    }
+
+    inline TransformMatrix readMatrix(BinaryReader& reader) {
+        return reader.read<TransformMatrix>();
+    }
+
+    inline D3DCOLORVALUE readD3ColorValue(BinaryReader& reader) {
+        return reader.read<D3DCOLORVALUE>();
+    }
+
+    std::string readString(BinaryReader& reader, int count);
+    std::vector<uint8_t> readBytes(BinaryReader& reader, size_t length);
+
+    std::string readZeroTerminatedString(BinaryReader& reader);
+    std::chrono::milliseconds readTimestamp(BinaryReader& reader);
+
+    uint32_t readCompressedInteger(BinaryReader& reader);
+
+    std::pair<std::vector<uint8_t>, size_t> readLZOCompressed(BinaryReader& reader, size_t expectedSize);
+    template<typename T>
+    std::pair<std::vector<T>, size_t> readLZOCompressed(BinaryReader& reader, size_t expectedSize);
+    // Moves past an LZO block without decoding it, returns its compressed size
+    size_t skipLZOCompressed(BinaryReader& reader, size_t expectedSize);
+
+    std::vector<uint8_t> readCompressed(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+
+    template<typename T>
+    std::vector<T> readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+
+    template<typename T>
+    std::vector<T> readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag, size_t arrSize);
+
+    template<typename T>
+    std::vector<T> readCompressedArrayOld(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+
+    template<typename T>
+    std::vector<T> readCompressedFillArray(BinaryReader& reader, bool useCompressionFlag);
+
     // Write
     template<typename T>
     void writeBytes(std::ostream& ofs, T t);
@@ -69,13 +133,29 @@ namespace grad_aff {
 
     void writeZeroTerminatedString(std::ostream& ofs, std::string string);
     void writeTimestamp(std::ostream& ofs, std::chrono::milliseconds milliseconds);
+    // Counterpart to readLZOCompressed, returns the compressed size
+    size_t writeLZOCompressed(std::ostream& ofs, ByteSpan data);
 
 
     // Compression
     std::vector<uint8_t> readCompressedLZOLZSS(std::istream& is, size_t expectedSize, bool useLzo);
     std::vector<uint8_t> readLzssBlock(std::istream& is, size_t expectedSize);
+    std::vector<uint8_t> readCompressedLZOLZSS(BinaryReader& reader, size_t expectedSize, bool useLzo);
+    std::vector<uint8_t> readLzssBlock(BinaryReader& reader, size_t expectedSize);
 
-    size_t readLzss(std::vector<uint8_t> in, std::vector<uint8_t>& out);
+    size_t readLzss(const std::vector<uint8_t>& in, std::vector<uint8_t>& out);
     size_t readLzssFile(std::istream& is, std::vector<uint8_t>& out);
-    size_t readLzssSized(std::istream& is, std::vector<uint8_t>& out, size_t expectedSize, bool useSignedChecksum);
+    size_t readLzssSized(std::istream& is, std::vector<uint8_t>& out, size_t expectedSize);
+    size_t readLzssSized(BinaryReader& reader, std::vector<uint8_t>& out, size_t expectedSize);
+
+    // Decodes the LZSS tokens in `in` straight into out, which doubles as the sliding window.
+    // With expectedSize 0 the size is unknown and decoding runs up to the 4 byte checksum trailer.
+    // Returns the number of bytes consumed, not counting the trailer.
+    size_t decodeLzss(ByteSpan in, std::vector<uint8_t>& out, size_t expectedSize = 0);
+    int32_t lzssChecksum(ByteSpan data, bool useSignedChecksum);
+    // decodeLzss plus checksum validation, returns the bytes consumed including the trailer or -1
+    size_t readLzss(ByteSpan in, std::vector<uint8_t>& out, size_t expectedSize, bool useSignedChecksum);
+
+    // Counterpart to readLzss, out receives flag/literal/match tokens and the checksum
+    size_t writeLzss(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, int maxChainLength = 256);
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "grad_aff.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace grad_aff {
+
+    // Work stealing pool behind parallelFor.
+    // Every worker has its own queue, tasks submitted from a worker go to that queue and idle workers steal the oldest ones.
+    // Tasks from other threads go to a shared queue. Threads waiting on the pool run queued tasks before they block,
+    // so nested parallel loops reuse the same workers instead of starting new threads.
+    class GRAD_AFF_API ThreadPool {
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        // one per worker, the shared queue is the last
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> queued{ 0 };
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        bool popTask(size_t queueIndex, std::function<void()>& task);
+        void workerLoop(size_t queueIndex);
+    public:
+        explicit ThreadPool(size_t threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // library wide pool, the calling thread works along so it has one thread less than the hardware
+        static ThreadPool& global();
+
+        size_t size() const noexcept;
+
+        // tasks must not throw, parallelFor catches and forwards exceptions itself
+        void submit(std::function<void()> task);
+        // runs one queued task on the calling thread, false if there was none
+        bool runPendingTask();
+    };
+}
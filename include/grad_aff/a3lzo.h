@@ -10,5 +10,9 @@
 #define M2_MAX_OFFSET   0x0800
 
 namespace grad_aff {
+    // Decodes one LZO1X stream, returns the number of input bytes it took
+    size_t Decompress(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize);
+    // Same checks as Decompress without producing output, for skipping a stream
+    size_t ScanCompressed(const uint8_t* input, size_t inputSize, size_t outputSize);
     size_t Decompress(std::istream& i, std::vector<uint8_t>& output, size_t expectedSize);
 };
@@ -21,7 +21,7 @@ namespace grad_aff {
     private:
         std::string filetype;
 
-        std::shared_ptr<std::istream> is;
+        BinaryReader reader;
 
 
         std::map<float_t, LodType> lodMap = {
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../grad_aff.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace grad_aff {
+
+    // BC1 (DXT1) and BC3 (DXT5) decoding to RGBA8 with the same results as squish.
+    // Blocks are expanded with SSE2 where available.
+
+    // one block into the 4x4 pixels at rgba, pitch is the byte distance between pixel rows
+    GRAD_AFF_API void decodeBc1Block(const uint8_t* block, uint8_t* rgba, size_t pitch);
+    GRAD_AFF_API void decodeBc3Block(const uint8_t* block, uint8_t* rgba, size_t pitch);
+
+    // Whole image of width * height * 4 bytes, rows of blocks are decoded in parallel.
+    // Parts of border blocks outside the image are dropped.
+    GRAD_AFF_API void decodeBc1(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
+    GRAD_AFF_API void decodeBc3(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
+}
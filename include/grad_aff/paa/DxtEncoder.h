@@ -0,0 +1,23 @@
+#pragma once
+
+#include "../grad_aff.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace grad_aff {
+
+    // Fast BC1 (DXT1) and BC3 (DXT5) encoding from RGBA8.
+    // Endpoints are the inset bounding box of the block colours, found with SSE2 where available,
+    // and every pixel takes the closest palette entry. Lower quality than squish's cluster fit, much quicker.
+
+    // the 4x4 pixels at rgba into one block, pitch is the byte distance between pixel rows.
+    // BC1 blocks with pixels below alpha 128 use the three colour mode with transparent black.
+    GRAD_AFF_API void encodeBc1Block(const uint8_t* rgba, size_t pitch, uint8_t* block);
+    GRAD_AFF_API void encodeBc3Block(const uint8_t* rgba, size_t pitch, uint8_t* block);
+
+    // Whole image of width * height * 4 bytes, rows of blocks are encoded in parallel.
+    // Border blocks repeat the last row and column of the image.
+    GRAD_AFF_API void encodeBc1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks);
+    GRAD_AFF_API void encodeBc3(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks);
+}
@@ -8,4 +8,8 @@ struct MipMap {
     uint32_t dataLength = 0;
     std::vector<uint8_t> data = {};
     bool lzoCompressed = false;
+    // DXT blocks as stored in the file, LZO compressed if lzoCompressed.
+    // Lazily read levels keep them until the pixels change, data is only filled once the level is decoded.
+    std::vector<uint8_t> dxtData = {};
+    bool decoded = true;
 };
\ No newline at end of file
@@ -36,6 +36,14 @@ namespace grad_aff {
             GRAYwAlpha
         };
 
+        // DXT encoder used by writePaa: Fast is a bounding box fit for iteration builds,
+        // Normal is squish's range fit and High squish's cluster fit
+        enum class DxtQuality {
+            Fast,
+            Normal,
+            High
+        };
+
     private:
         uint16_t magicNumber = 0;
         Palette palette;
@@ -43,12 +51,21 @@ namespace grad_aff {
         size_t averageBlue = 0;
         size_t averageGreen = 0;
         size_t averageAlpha = 0;
-
-        void readPaa(std::shared_ptr<std::istream> is, bool peek);
-        void writePaa(std::ostream& os, TypeOfPaX typeOfPaX = TypeOfPaX::UNKNOWN);
+        // format of the dxtData of lazily read mipmaps, writePaa can change typeOfPax
+        TypeOfPaX dxtType = TypeOfPaX::UNKNOWN;
+
+        // decodes the dxtData of mipMap into RGBA pixels, the DXT blocks are kept
+        void decodeMipMap(MipMap& mipMap) const;
+        // replaces LZO compressed dxtData with the plain blocks
+        void unpackMipMap(MipMap& mipMap) const;
+        void readPaa(BinaryReader& reader, bool peek);
+        void writePaa(std::ostream& os, TypeOfPaX typeOfPaX = TypeOfPaX::UNKNOWN, DxtQuality dxtQuality = DxtQuality::High);
     public:
         bool hasTransparency = false;
         TypeOfPaX typeOfPax;
+        // Keep DXT mipmaps compressed when reading, levels are decoded on first access.
+        // Untouched levels are written back verbatim if the format stays the same.
+        bool lazyDecode = false;
 
         std::vector<MipMap> mipMaps = {};
         std::vector<Tagg> taggs = {};
@@ -58,19 +75,23 @@ namespace grad_aff {
         void readPaa(std::string filename, bool peek = false);
         void readPaa(std::vector<uint8_t> data, bool peek = false);
 
-        void writePaa(std::string filename, TypeOfPaX typeOfPaX = TypeOfPaX::UNKNOWN);
-        std::vector<uint8_t> writePaa(TypeOfPaX typeOfPaX = TypeOfPaX::UNKNOWN);
+        void writePaa(std::string filename, TypeOfPaX typeOfPaX = TypeOfPaX::UNKNOWN, DxtQuality dxtQuality = DxtQuality::High);
+        std::vector<uint8_t> writePaa(TypeOfPaX typeOfPaX = TypeOfPaX::UNKNOWN, DxtQuality dxtQuality = DxtQuality::High);
 
         void calculateMipmapsAndTaggs();
 
+        // decodes the level if needed
         std::vector<uint8_t> getRawPixelData(uint8_t level = 0);
+        // only decodes the 4x4 block around x/y of a level that isn't decoded yet
         std::array<uint8_t, 4> getRawPixelDataAt(size_t x, size_t y, uint8_t level = 0);
 
         void setRawPixelData(std::vector<uint8_t> data, uint8_t level = 0);
         void setRawPixelDataAt(size_t x, size_t y, std::array<uint8_t, 4> data, uint8_t level = 0);
 
         void setMipMaps(std::vector<MipMap> mipMaps);
+        // lazily read levels are returned as they are, see decodeMipMaps
         std::vector<MipMap> getMipMaps() const;
+        void decodeMipMaps();
 
         bool getHasTransparency() const;
         bool isValid() const noexcept;
@@ -13,4 +13,8 @@ struct Entry {
     uint32_t timestamp = 0;
     std::vector<uint8_t> data = {};
     uint32_t dataSize = 0;
+    // absolute position of the data block inside the archive
+    uint64_t dataOffset = 0;
+    // file the data is streamed from when packing, empty if data is held in memory
+    fs::path sourcePath = "";
 };
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 #include "../grad_aff.h"
 #include "../StreamUtil.h"
+#include "../Span.h"
+#include "../BinaryReader.h"
 #include "Entry.h"
 
 #include <tsl/ordered_map.h>
@@ -17,27 +19,49 @@ namespace fs = std::filesystem;
 
 namespace grad_aff {
     class GRAD_AFF_API Pbo {
-        std::shared_ptr<std::istream> is;  
-        std::streampos dataPos = 0;
-        std::streampos preHashPos = 0;
+        // whole archive, memory mapped or the buffer it was created from
+        BinaryReader reader;
+        // file behind reader, empty for archives created from a buffer
+        fs::path filePath;
+        size_t dataPos = 0;
+        size_t preHashPos = 0;
+
+        std::shared_ptr<Entry> findEntry(fs::path entryPath);
+        static bool isCompressed(const Entry& entry);
+        static std::vector<uint8_t> unpackEntry(const Entry& entry, std::vector<uint8_t> data);
+        static std::vector<uint8_t> unpackEntry(const Entry& entry, ByteSpan data);
     public:
         Pbo(std::string filename);
         Pbo(std::vector<uint8_t> data, std::string pboName = "");
         void readPbo(bool withData = true);
+        // Hashes the raw archive, nothing gets unpacked
         bool checkHash();
-        void extractPbo(fs::path outPath);
+        // Verifies many archives in parallel, unreadable files count as mismatch
+        static std::vector<bool> checkHashes(const std::vector<fs::path>& pboPaths);
+        // Unpacks and writes entries in parallel, entries that aren't loaded yet are read on demand.
+        // maxInFlightBytes bounds the raw + unpacked data held in memory at once.
+        void extractPbo(fs::path outPath, size_t maxInFlightBytes = 256 * 1024 * 1024);
         void extractSingleFile(fs::path entryName, fs::path outPath, bool fullPath = true);
 
-        void writePbo(fs::path outPath);
+        // Streams the archive to outPath/pboName.pbo and hashes it on the fly. Entries added via
+        // addFile/addDir are read from disk chunk by chunk, unloaded entries are copied from the source.
+        // With compress, loaded and added entries are LZSS packed in parallel where it saves space.
+        // Writing over the archive the Pbo was opened from reads the header of the new file afterwards,
+        // views from getEntryView into the old archive are invalid then.
+        void writePbo(fs::path outPath, bool compress = false);
     
         void readSingleData(fs::path entryPath);
         bool hasEntry(fs::path entryPath);
 
         void addFile(fs::path file);
+        void addFile(fs::path file, fs::path entryPath);
         void addDir(fs::path dir);
         void removeFile(fs::path file);
 
         std::vector<uint8_t> getEntryData(fs::path entryPath);
+        // Uncompressed entries of the archive point directly into it,
+        // everything else into the entries data. Only valid as long as the Pbo lives.
+        ByteSpan getEntryView(fs::path entryPath);
 
         std::vector<uint8_t> readEntry(const Entry& entryPtr);
 
@@ -22,12 +22,12 @@ using SubType = std::variant<RapClass, RapValue, RapArray, RapExtern, RapDelete,
 namespace grad_aff {
     class GRAD_AFF_API Rap {
     private:
-        std::shared_ptr<std::istream> is;
+        BinaryReader reader;
 
-        std::shared_ptr<RapArray> readArray(std::istream& is);
-        std::string readClassBody(std::istream& is, std::vector<std::shared_ptr<ClassEntry>>& classes);
+        std::shared_ptr<RapArray> readArray(BinaryReader& reader);
+        std::string readClassBody(BinaryReader& reader, std::vector<std::shared_ptr<ClassEntry>>& classes);
 
-        std::shared_ptr<ClassEntry> readClassEntry(std::istream& is);
+        std::shared_ptr<ClassEntry> readClassEntry(BinaryReader& reader);
 
     public:
         Rap();
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../grad_aff.h"
+#include "../Types.h"
+
+#include <utility>
+#include <vector>
+
+namespace grad_aff {
+
+    class Wrp;
+
+    // Height queries on a terrain grid, heights[x + y * sizeX] is the height at (x * gridSize, y * gridSize).
+    // Positions outside the grid are clamped to its border.
+    // Like the engine, every grid square is split into two triangles along the (1,0)-(0,1) diagonal.
+    class GRAD_AFF_API Heightmap {
+        uint32_t sizeX = 0;
+        uint32_t sizeY = 0;
+        float_t gridSize = 0;
+        float_t invGridSize = 0;
+        std::vector<float_t> heights = {};
+
+        // level 0 holds min/max of each grid square, every further level merges 2x2 squares of the previous one
+        struct PyramidLevel {
+            uint32_t sizeX = 0;
+            uint32_t sizeY = 0;
+            std::vector<float_t> minHeights = {};
+            std::vector<float_t> maxHeights = {};
+        };
+        std::vector<PyramidLevel> pyramid = {};
+
+        void buildPyramid();
+        // grid square of x/y and the position inside it
+        void locate(float_t x, float_t y, uint32_t& cellX, uint32_t& cellY, float_t& fx, float_t& fy) const;
+    public:
+        Heightmap() = default;
+        Heightmap(std::vector<float_t> heights, uint32_t sizeX, uint32_t sizeY, float_t gridSize);
+        // terrain grid and elevation of a read Wrp
+        Heightmap(const Wrp& wrp);
+
+        bool empty() const noexcept;
+        uint32_t getSizeX() const noexcept;
+        uint32_t getSizeY() const noexcept;
+        float_t getGridSize() const noexcept;
+        // height at a grid point
+        float_t getHeight(uint32_t x, uint32_t y) const;
+
+        // height on the terrain triangles, what the engine places objects on
+        float_t sampleHeight(float_t x, float_t y) const;
+        float_t sampleBilinear(float_t x, float_t y) const;
+        // unit normal of the terrain triangle, as x, height, y like object positions
+        XYZTriplet sampleNormal(float_t x, float_t y) const;
+        // sampleHeight for count points, four at a time with SSE2 where available
+        void sampleHeights(const float_t* x, const float_t* y, float_t* result, size_t count) const;
+
+        // false if the terrain rises above the straight line between from and to.
+        // Positions are x, height, y like object positions.
+        bool lineOfSight(const XYZTriplet& from, const XYZTriplet& to) const;
+
+        // conservative min/max height within the rectangle, answered from the pyramid
+        std::pair<float_t, float_t> getHeightRange(float_t minX, float_t minY, float_t maxX, float_t maxY) const;
+        size_t getPyramidLevels() const noexcept;
+        std::pair<float_t, float_t> getPyramidRange(size_t level, uint32_t x, uint32_t y) const;
+    };
+}
@@ -2,9 +2,40 @@
 
 #include "MapType.h"
 
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
+// Map info records of a terrain, one array per record layout
 struct MapInfo {
-    uint32_t infoType = 0;
-    std::vector<MapType> mapData = {};
-};
\ No newline at end of file
+    std::vector<MapType1> mapTypes1 = {};
+    std::vector<MapType2> mapTypes2 = {};
+    std::vector<MapType3> mapTypes3 = {};
+    std::vector<MapType4> mapTypes4 = {};
+    std::vector<MapType5> mapTypes5 = {};
+    std::vector<MapType35> mapTypes35 = {};
+
+    // file order as mapType and index into the array of that type
+    std::vector<std::pair<uint32_t, uint32_t>> order = {};
+
+    size_t size() const noexcept { return order.size(); }
+    bool empty() const noexcept { return order.empty(); }
+
+    void clear() {
+        *this = {};
+    }
+
+    // i-th record in file order
+    const MapType& at(size_t i) const {
+        auto [mapType, index] = order.at(i);
+        switch (mapType) {
+        case 1: return mapTypes1[index];
+        case 2: return mapTypes2[index];
+        case 3: return mapTypes3[index];
+        case 4: return mapTypes4[index];
+        case 5: return mapTypes5[index];
+        case 35: return mapTypes35[index];
+        }
+        throw std::runtime_error("Invalid mapType");
+    }
+};
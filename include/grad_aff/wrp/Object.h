@@ -8,7 +8,9 @@
 
 struct Object {
     uint32_t objectId = 0;
-    uint32_t modelIndex = 0;
+    uint32_t modelIndex = 0; // index 0 -> no model?
     std::array<XYZTriplet, 4> transformMatrix = {};
-    uint32_t static0x02 = 0;
-};
\ No newline at end of file
+    uint32_t static0x02 = 0x02; // always 2 in the files, the reader checks it
+};
+
+static_assert(sizeof(Object) == GRAD_AFF_SIZE_OF_WRPOBJECT, "Object has to match the on disk layout");
\ No newline at end of file
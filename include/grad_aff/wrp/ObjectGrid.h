@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../grad_aff.h"
+#include "../Types.h"
+
+#include "ObjectTable.h"
+
+#include <array>
+#include <vector>
+
+namespace grad_aff {
+
+    // Uniform grid over the objects of a terrain, the objects of each cell are stored contiguously (CSR).
+    // Queries use map coordinates, x and y are position[0] and position[2] of the objects.
+    // Results are indices into the ObjectTable the grid was built from.
+    class GRAD_AFF_API ObjectGrid {
+        float_t cellSize = 0;
+        uint32_t cellsX = 0;
+        uint32_t cellsY = 0;
+
+        // objects of cell c are cellObjects[cellStart[c], cellStart[c + 1]), cells are row major
+        std::vector<uint32_t> cellStart = {};
+        std::vector<uint32_t> cellObjects = {};
+        // x/y of cellObjects in the same order, so queries don't touch the object table
+        std::vector<std::array<float_t, 2>> cellPositions = {};
+
+        uint32_t cellIndexX(float_t x) const;
+        uint32_t cellIndexY(float_t y) const;
+    public:
+        // Objects outside of cellsX * cellsY cells are put into the nearest border cell
+        void build(const ObjectTable& objects, float_t cellSize, uint32_t cellsX, uint32_t cellsY);
+        void clear();
+        bool empty() const noexcept;
+
+        // result is cleared first, so it can be reused between queries
+        void queryRect(float_t minX, float_t minY, float_t maxX, float_t maxY, std::vector<uint32_t>& result) const;
+        void queryRadius(float_t x, float_t y, float_t radius, std::vector<uint32_t>& result) const;
+        // the k closest objects, closest first
+        void queryNearest(float_t x, float_t y, size_t k, std::vector<uint32_t>& result) const;
+
+        std::vector<uint32_t> queryRect(float_t minX, float_t minY, float_t maxX, float_t maxY) const;
+        std::vector<uint32_t> queryRadius(float_t x, float_t y, float_t radius) const;
+        std::vector<uint32_t> queryNearest(float_t x, float_t y, size_t k) const;
+    };
+}
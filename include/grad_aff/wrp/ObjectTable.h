@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../grad_aff.h"
+#include "../BinaryReader.h"
+#include "../Types.h"
+
+#include "Object.h"
+
+#include <vector>
+
+using ObjectRotation = std::array<XYZTriplet, 3>;
+
+namespace grad_aff {
+
+    // Objects of a terrain as one array per field, index i is the i-th object of the file.
+    // Ids are looked up by binary search, ids are ascending in regular WRPs so no index is needed.
+    class GRAD_AFF_API ObjectTable {
+        std::vector<uint32_t> objectIds = {};
+        std::vector<uint32_t> modelIndices = {};
+        std::vector<XYZTriplet> positions = {};
+        std::vector<ObjectRotation> rotations = {};
+
+        // object indices sorted by id, only built once the ids stop ascending
+        std::vector<uint32_t> idOrder = {};
+
+        void buildIdOrder();
+    public:
+        static constexpr size_t npos = (size_t)-1;
+
+        // reads count on disk records of GRAD_AFF_SIZE_OF_WRPOBJECT bytes
+        void readObjects(BinaryReader& reader, size_t count);
+        void addObject(const Object& object);
+        void reserve(size_t count);
+        void clear();
+
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+
+        Object getObject(size_t index) const;
+        // index of the object or npos, the first one for duplicate ids
+        size_t findObject(uint32_t objectId) const;
+
+        const std::vector<uint32_t>& getObjectIds() const noexcept;
+        const std::vector<uint32_t>& getModelIndices() const noexcept;
+        const std::vector<XYZTriplet>& getPositions() const noexcept;
+        const std::vector<ObjectRotation>& getRotations() const noexcept;
+    };
+}
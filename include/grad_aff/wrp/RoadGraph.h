@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../grad_aff.h"
+#include "../Types.h"
+
+#include "RoadNet.h"
+
+#include <array>
+#include <vector>
+
+namespace grad_aff {
+
+    // Closest point on a road segment
+    struct RoadHit {
+        uint32_t segment = 0;
+        float_t distance = 0;
+        // position along the segment, 0 at its first node
+        float_t t = 0;
+        XYZTriplet position = {};
+    };
+
+    // Road parts joined into one graph, positions are x, height, y like in the road parts.
+    // Part vertices closer than the weld distance become one node, consecutive vertices of a part are connected by a segment.
+    // Segments are also kept in a uniform grid for nearest road queries.
+    class GRAD_AFF_API RoadGraph {
+        std::vector<XYZTriplet> nodePositions = {};
+
+        // edges of node n are edgeTargets/edgeLengths[edgeStart[n], edgeStart[n + 1])
+        std::vector<uint32_t> edgeStart = {};
+        std::vector<uint32_t> edgeTargets = {};
+        std::vector<float_t> edgeLengths = {};
+
+        std::vector<std::array<uint32_t, 2>> segmentNodes = {};
+        std::vector<float_t> segmentLengths = {};
+        // road part of each segment, counting the parts of all road nets in order
+        std::vector<uint32_t> segmentParts = {};
+
+        float_t cellSize = 0;
+        float_t originX = 0;
+        float_t originY = 0;
+        uint32_t cellsX = 0;
+        uint32_t cellsY = 0;
+        std::vector<uint32_t> cellStart = {};
+        std::vector<uint32_t> cellSegments = {};
+
+        void buildSegmentGrid();
+        uint32_t cellIndexX(float_t x) const;
+        uint32_t cellIndexY(float_t y) const;
+    public:
+        static constexpr uint32_t npos = (uint32_t)-1;
+
+        void build(const std::vector<RoadNet>& roadNets, float_t weldDistance = 0.5f);
+        void clear();
+        bool empty() const noexcept;
+
+        size_t getNodeCount() const noexcept;
+        size_t getSegmentCount() const noexcept;
+
+        // false if there are no roads
+        bool nearestRoad(float_t x, float_t y, RoadHit& hit) const;
+        // node closest to x/y along the nearest road, npos if there are no roads
+        uint32_t nearestNode(float_t x, float_t y) const;
+        // A* over the segment lengths, returns the length and the nodes from start to goal.
+        // Unreachable goals return infinity and an empty path.
+        float_t shortestPath(uint32_t start, uint32_t goal, std::vector<uint32_t>& path) const;
+
+        const std::vector<XYZTriplet>& getNodePositions() const noexcept;
+        const std::vector<uint32_t>& getEdgeStart() const noexcept;
+        const std::vector<uint32_t>& getEdgeTargets() const noexcept;
+        const std::vector<float_t>& getEdgeLengths() const noexcept;
+        const std::vector<std::array<uint32_t, 2>>& getSegmentNodes() const noexcept;
+        const std::vector<float_t>& getSegmentLengths() const noexcept;
+        const std::vector<uint32_t>& getSegmentParts() const noexcept;
+    };
+}
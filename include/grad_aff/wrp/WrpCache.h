@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../grad_aff.h"
+#include "../Types.h"
+#include "../Span.h"
+#include "../MemoryMappedFile.h"
+
+#include "ObjectTable.h"
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace grad_aff {
+
+    class Wrp;
+
+    // Identifies the WRP a cache was made from
+    struct GRAD_AFF_API WrpCacheSource {
+        uint64_t size = 0;
+        // last write time in file clock ticks, 0 for in memory sources
+        int64_t time = 0;
+        uint64_t hash = 0;
+
+        static WrpCacheSource fromFile(const fs::path& path);
+        static WrpCacheSource fromData(ByteSpan data);
+        static uint64_t hashData(ByteSpan data);
+    };
+
+    // Parsed terrain data as flat arrays in one file, opened by mapping it.
+    // Nothing is decoded on open, every getter is a view into the mapping.
+    class GRAD_AFF_API WrpCache {
+    public:
+        static constexpr uint32_t formatVersion = 1;
+
+        enum Array : uint32_t {
+            ArrayElevation,
+            ArrayObjectIds,
+            ArrayModelIndices,
+            ArrayPositions,
+            ArrayRotations,
+            // models are stored as offsets into one block of chars, count + 1 offsets
+            ArrayModelOffsets,
+            ArrayModelChars,
+            ArrayRoadNodes,
+            ArrayEdgeStart,
+            ArrayEdgeTargets,
+            ArrayEdgeLengths,
+            ArraySegmentNodes,
+            ArraySegmentLengths,
+            ArraySegmentParts,
+            ArrayCount
+        };
+
+        struct ArrayEntry {
+            uint64_t offset = 0;
+            uint64_t count = 0;
+        };
+
+        // on disk header, arrays follow aligned to 16 bytes
+        struct Header {
+            std::array<char, 4> magic = { 'G', 'A', 'W', 'C' };
+            uint32_t version = formatVersion;
+            WrpCacheSource source = {};
+            uint32_t wrpVersion = 0;
+            uint32_t appId = 0;
+            uint32_t layerSizeX = 0;
+            uint32_t layerSizeY = 0;
+            uint32_t mapSizeX = 0;
+            uint32_t mapSizeY = 0;
+            float_t layerCellSize = 0;
+            uint32_t maxObjectId = 0;
+            std::array<ArrayEntry, ArrayCount> arrays = {};
+        };
+    private:
+        std::shared_ptr<MemoryMappedFile> file = {};
+        const Header* header = nullptr;
+
+        template<typename T>
+        Span<const T> getArray(Array array) const {
+            const auto& entry = header->arrays[array];
+            return Span<const T>(reinterpret_cast<const T*>(file->data() + entry.offset), (size_t)entry.count);
+        }
+    public:
+        // Maps the cache and checks its header and array bounds, throws for files that aren't a cache of this version
+        WrpCache(const fs::path& path);
+
+        // Writes the loaded sections of wrp, see Wrp::writeCache
+        static void write(const Wrp& wrp, const fs::path& path, const WrpCacheSource& source);
+
+        // Size and write time have to match, with compareHash or a changed write time the contents are hashed
+        bool isValidFor(const fs::path& sourcePath, bool compareHash = false) const;
+
+        const Header& getHeader() const noexcept;
+
+        Span<const float_t> getElevation() const;
+
+        size_t getObjectCount() const;
+        Span<const uint32_t> getObjectIds() const;
+        Span<const uint32_t> getModelIndices() const;
+        Span<const XYZTriplet> getPositions() const;
+        Span<const ObjectRotation> getRotations() const;
+
+        size_t getModelCount() const;
+        std::string_view getModel(size_t index) const;
+
+        Span<const XYZTriplet> getRoadNodePositions() const;
+        Span<const uint32_t> getRoadEdgeStart() const;
+        Span<const uint32_t> getRoadEdgeTargets() const;
+        Span<const float_t> getRoadEdgeLengths() const;
+        Span<const std::array<uint32_t, 2>> getRoadSegmentNodes() const;
+        Span<const float_t> getRoadSegmentLengths() const;
+        Span<const uint32_t> getRoadSegmentParts() const;
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../grad_aff.h"
+#include "../Types.h"
+#include "../Span.h"
+#include "../GridBlockTree.h"
+
+#include "ClassedModel.h"
+#include "MapInfo.h"
+#include "Object.h"
+#include "ObjectTable.h"
+#include "RoadNet.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace grad_aff {
+
+    // Writes an OPRW terrain section by section, in file order.
+    // Objects and map info can be written in any number of batches, only the current batch is held in memory.
+    // Sizes and counts that precede the sections are patched in by finish(), so the stream has to be seekable.
+    class GRAD_AFF_API WrpWriter {
+        // last part written, objects and map info are optional and can be written repeatedly
+        enum class Stage { Header, Layers, Grids, Models, Blocks, RoadNets, Objects, MapInfo, Done };
+
+        std::ostream& os;
+        Stage stage = Stage::Header;
+
+        uint32_t layerSizeX = 0;
+        uint32_t layerSizeY = 0;
+        uint32_t mapSizeX = 0;
+        uint32_t mapSizeY = 0;
+        float_t layerCellSize = 0;
+
+        std::streampos sizeOfObjectsPos = -1;
+        std::streampos sizeOfMapInfoPos = -1;
+        std::streampos maxObjectIdPos = -1;
+        std::streampos sizeOfRoadNetsPos = -1;
+        uint64_t objectCount = 0;
+        uint32_t largestObjectId = 0;
+        uint64_t mapInfoSize = 0;
+        uint64_t roadNetsSize = 0;
+
+        // throws if the parts before next weren't written yet or next was already written
+        void advance(Stage next);
+        void writeGridBlock(const GridBlockTree& tree);
+        void writeABPacket(const GridBlockTree& tree, uint32_t nodeIndex);
+        void writeRoadPart(const RoadPart& roadPart);
+    public:
+        static constexpr size_t objectBatchSize = 4096;
+
+        // writes the header, appId is only stored for version 25 and later
+        WrpWriter(std::ostream& os, uint32_t layerSizeX, uint32_t layerSizeY, uint32_t mapSizeX, uint32_t mapSizeY,
+            float_t layerCellSize, uint32_t appId = 0, uint32_t version = 25);
+
+        void writeLayers(const GridBlockTree& geography, const GridBlockTree& cfgEnvSounds,
+            const std::vector<XYZTriplet>& peaks, const GridBlockTree& rvmatLayerIndex);
+        // mapSizeX * mapSizeY values each, empty arrays are written as zeros
+        void writeGrids(ByteSpan randomClutter, ByteSpan compressedBytes, Span<const float_t> elevation);
+        void writeModels(const std::vector<std::string>& rvmats, const std::vector<std::string>& models,
+            const std::vector<ClassedModel>& classedModels);
+        // compressedBytes2 has layerSizeX * layerSizeY values, compressedBytes3 mapSizeX * mapSizeY, empty ones are zeros
+        void writeBlocks(const GridBlockTree& unknownGridBlock3, const GridBlockTree& unknownGridBlock4,
+            ByteSpan compressedBytes2, ByteSpan compressedBytes3);
+        // every net is stored in the layer cell of its first position
+        void writeRoadNets(const std::vector<RoadNet>& roadNets);
+
+        // records are written as they are
+        void writeObjects(const Object* objects, size_t count);
+        void writeObjects(const std::vector<Object>& objects);
+        void writeObjects(const ObjectTable& objects);
+        // objects from any iterator range, converted in batches of objectBatchSize
+        template<typename It>
+        void writeObjects(It first, It last) {
+            std::vector<Object> batch;
+            batch.reserve(objectBatchSize);
+            for (; first != last; ++first) {
+                batch.push_back(*first);
+                if (batch.size() == objectBatchSize) {
+                    writeObjects(batch);
+                    batch.clear();
+                }
+            }
+            writeObjects(batch);
+        }
+
+        void writeMapInfo(const MapInfo& mapInfo);
+
+        // patches the sizes, with maxObjectId 0 the largest object id written is stored
+        void finish(uint32_t maxObjectId = 0);
+    };
+}
@@ -8,8 +8,13 @@
 
 #include "ClassedModel.h"
 #include "RoadNet.h"
-#include "Object.h"
+#include "RoadGraph.h"
+#include "ObjectTable.h"
+#include "ObjectGrid.h"
+#include "Heightmap.h"
 #include "MapInfo.h"
+#include "WrpWriter.h"
+#include "WrpCache.h"
 
 #include <iostream>
 #include <vector>
@@ -26,12 +31,40 @@ namespace fs = std::filesystem;
 namespace grad_aff {
     class GRAD_AFF_API Wrp {
     private:
-        std::shared_ptr<std::istream> is;
+        BinaryReader reader;
         // infoTypes
-        std::shared_ptr<GridBlockTree> readGridBlock(std::istream& ifs, size_t dataSize);
-        std::shared_ptr<GridBlockTree> readABPacket(std::istream& ifs, size_t dataSize);
-        std::shared_ptr<GridBlockTree> readABPair(std::istream& ifs, size_t dataSize);
+        GridBlockTree readGridBlock(BinaryReader& reader, size_t dataSize);
+        // appends the packet and its children to tree, returns the index of the packet
+        uint32_t readABPacket(BinaryReader& reader, GridBlockTree& tree, uint32_t depth);
+        void skipABPacket(BinaryReader& reader, size_t dataSize);
+        void skipGridBlock(BinaryReader& reader, size_t dataSize);
+
+        // where each section starts, so skipped sections can be loaded later
+        uint32_t loadedSections = 0;
+        std::array<size_t, 5> gridBlockOffsets = {};
+        std::array<size_t, 9> sectionOffsets = {};
+
+        static size_t sectionIndex(uint32_t section);
+        // decodes sections from their recorded offsets, in parallel
+        void readSections(uint32_t sections);
+        void readSection(BinaryReader& reader, uint32_t section);
+        void skipSection(uint32_t section);
+        void readMapInfo(BinaryReader& reader);
     public:        
+        // Sections for readWrp/loadSections, everything else in the file is always read
+        enum Section : uint32_t {
+            SectionGridBlocks = 1 << 0,
+            SectionRandomClutter = 1 << 1,
+            SectionCompressedBytes = 1 << 2,
+            SectionElevation = 1 << 3,
+            SectionCompressedBytes2 = 1 << 4,
+            SectionCompressedBytes3 = 1 << 5,
+            SectionRoadNets = 1 << 6,
+            SectionObjects = 1 << 7,
+            SectionMapInfo = 1 << 8,
+            SectionAll = (1 << 9) - 1
+        };
+
         const std::array<uint8_t, 16> infoTypes1 = { 0, 1, 2, 10, 11, 12, 13, 14, 15, 16, 17, 22, 23, 26, 27, 30 }; // 12 (cham)
         const std::array<uint8_t, 3> infoType2 = { 24, 31, 32 };
         const std::array<uint8_t, 5> infoTypes3 = { 25, 33, 41, 42, 43 }; // 41, 42, 43 (stratis)
@@ -39,8 +72,15 @@ namespace grad_aff {
 
         Wrp(std::string filename);
         Wrp(std::vector<uint8_t> data);
-        void readWrp();
+        // Skipped sections are walked over without decoding and left empty
+        void readWrp(uint32_t sections = SectionAll);
+        // Decodes skipped sections from their recorded offsets, loaded ones are left alone
+        void loadSections(uint32_t sections);
+        bool isLoaded(uint32_t sections) const noexcept;
+        // Writes all sections, loading skipped ones first. An empty path overwrites the file that was read.
         void writeWrp(fs::path path = "");
+        // Loads elevation, objects and roads if needed and writes them to a WrpCache stamped with the source file
+        void writeCache(const fs::path& cachePath);
 
         std::string wrpName = "";
         std::string wrpTypeName = "";
@@ -54,10 +94,10 @@ namespace grad_aff {
         uint32_t layerSize = 0;
         float_t layerCellSize = 0;
 
-        std::shared_ptr<GridBlockTree> geography = {};
-        std::shared_ptr<GridBlockTree> cfgEnvSounds = {};
+        GridBlockTree geography = {};
+        GridBlockTree cfgEnvSounds = {};
         std::vector<XYZTriplet> peaks = {};
-        std::shared_ptr<GridBlockTree> rvmatLayerIndex = {};
+        GridBlockTree rvmatLayerIndex = {};
 
         std::vector<uint8_t> randomClutter = {};
         std::vector<uint8_t> compressedBytes = {};
@@ -66,9 +106,9 @@ namespace grad_aff {
         std::vector<std::string> models = {};
         std::vector<ClassedModel> classedModels = {};
 
-        std::shared_ptr<GridBlockTree> unknownGridBlock3 = {};
+        GridBlockTree unknownGridBlock3 = {};
         uint32_t sizeOfObjects = 0;
-        std::shared_ptr<GridBlockTree> unknownGridBlock4 = {};
+        GridBlockTree unknownGridBlock4 = {};
         uint32_t sizeOfMapInfo = 0;
 
         std::vector<uint8_t> compressedBytes2 = {};
@@ -78,8 +118,11 @@ namespace grad_aff {
         uint32_t sizeOfRoadNets = 0;
 
         std::vector<RoadNet> roadNets = {};
-        std::vector<Object> objects = {};
-        std::vector<std::shared_ptr<MapType>> mapInfo = {};
-        std::unordered_map<uint32_t, Object> objectIdMap = {};
+        // roads joined into a graph, built after reading
+        RoadGraph roadGraph = {};
+        ObjectTable objects = {};
+        // index over objects, built after reading
+        ObjectGrid objectGrid = {};
+        MapInfo mapInfo = {};
     };
 }
\ No newline at end of file
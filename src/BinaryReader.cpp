@@ -0,0 +1,32 @@
+#include "grad_aff/BinaryReader.h"
+
+#include "grad_aff/MemoryMappedFile.h"
+
+grad_aff::BinaryReader::BinaryReader(ByteSpan buffer, std::shared_ptr<const void> owner)
+    : buffer(buffer), owner(std::move(owner))
+{
+}
+
+grad_aff::BinaryReader::BinaryReader(std::vector<uint8_t> data) {
+    // take ownership of the vector, its heap buffer doesn't move with it
+    auto ownedData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    this->buffer = ByteSpan(*ownedData);
+    this->owner = ownedData;
+}
+
+grad_aff::BinaryReader grad_aff::BinaryReader::fromFile(const fs::path& path) {
+    try {
+        auto mappedFile = std::make_shared<MemoryMappedFile>(path);
+        return BinaryReader(mappedFile->span(), mappedFile);
+    }
+    catch (const std::runtime_error&) {
+        return BinaryReader();
+    }
+}
+
+void grad_aff::BinaryReader::seek(size_t newPosition) {
+    if (newPosition > buffer.size()) {
+        throw std::out_of_range("Seek past the end of the buffer");
+    }
+    position = newPosition;
+}
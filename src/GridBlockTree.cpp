@@ -1,18 +1,60 @@
 #include <grad_aff/GridBlockTree.h>
 
-grad_aff::GridBlockTree::GridBlockTree()
+#include <algorithm>
+#include <cstring>
+
+bool grad_aff::GridBlockTree::empty() const noexcept
+{
+    return nodes.empty();
+}
+
+void grad_aff::GridBlockTree::clear()
 {
-    this->isLeaf = false;
-    this->data = {};
+    nodes.clear();
+    leafData.clear();
+    leafSize = 0;
+    levels = 0;
 }
 
-grad_aff::GridBlockTree::GridBlockTree(bool isLeaf, std::vector<uint8_t> data)
+size_t grad_aff::GridBlockTree::leafCount() const noexcept
 {
-    this->isLeaf = isLeaf;
-    this->data = data;
+    return leafSize == 0 ? 0 : leafData.size() / leafSize;
+}
+
+grad_aff::ByteSpan grad_aff::GridBlockTree::getLeaf(size_t leafIndex) const
+{
+    return ByteSpan(leafData).subspan(leafIndex * leafSize, leafSize);
+}
+
+grad_aff::ByteSpan grad_aff::GridBlockTree::getLeaf(uint32_t x, uint32_t y) const
+{
+    if (nodes.empty() || levels == 0 || 2 * levels > 32) {
+        return {};
+    }
+    auto size = (uint64_t)1 << (2 * levels);
+    if (x >= size || y >= size) {
+        return {};
+    }
+
+    uint32_t node = 0;
+    for (uint32_t level = 0; level < levels; level++) {
+        auto shift = 2 * (levels - 1 - level);
+        auto slot = nodes[node][((x >> shift) & 3) + 4 * ((y >> shift) & 3)];
+        if (slot & leafFlag) {
+            return ByteSpan(leafData.data() + (size_t)(slot & ~leafFlag) * leafSize, leafSize);
+        }
+        node = slot;
+    }
+    return {};
 }
 
-void grad_aff::GridBlockTree::addChild(std::shared_ptr<GridBlockTree> gridBlockTree)
+uint32_t grad_aff::GridBlockTree::getValue(uint32_t x, uint32_t y) const
 {
-    this->children.push_back(gridBlockTree);
+    auto leaf = getLeaf(x, y);
+    uint32_t value = 0;
+    if (leaf.empty()) {
+        return value;
+    }
+    std::memcpy(&value, leaf.data(), std::min<size_t>(leaf.size(), sizeof(value)));
+    return value;
 }
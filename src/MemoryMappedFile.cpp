@@ -0,0 +1,106 @@
+#include "grad_aff/MemoryMappedFile.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+grad_aff::MemoryMappedFile::MemoryMappedFile(const fs::path& path) {
+    // sharing delete lets writers replace the file by renaming over it while it is mapped
+    fileHandle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        throw std::runtime_error("Couldn't open file for mapping: " + path.string());
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Couldn't get size of file: " + path.string());
+    }
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+
+    // empty files can't be mapped, treat them as an empty span
+    if (mappedSize == 0) {
+        return;
+    }
+
+    mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Couldn't map file: " + path.string());
+    }
+
+    mappedData = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (mappedData == nullptr) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Couldn't map file: " + path.string());
+    }
+}
+
+grad_aff::MemoryMappedFile::~MemoryMappedFile() {
+    if (mappedData != nullptr) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+}
+#else
+grad_aff::MemoryMappedFile::MemoryMappedFile(const fs::path& path) {
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Couldn't open file for mapping: " + path.string());
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1) {
+        close(fd);
+        throw std::runtime_error("Couldn't get size of file: " + path.string());
+    }
+    mappedSize = static_cast<size_t>(fileStat.st_size);
+
+    // empty files can't be mapped, treat them as an empty span
+    if (mappedSize == 0) {
+        close(fd);
+        return;
+    }
+
+    auto mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Couldn't map file: " + path.string());
+    }
+    mappedData = static_cast<const uint8_t*>(mapping);
+}
+
+grad_aff::MemoryMappedFile::~MemoryMappedFile() {
+    if (mappedData != nullptr) {
+        munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+    }
+}
+#endif
+
+const uint8_t* grad_aff::MemoryMappedFile::data() const noexcept {
+    return mappedData;
+}
+
+size_t grad_aff::MemoryMappedFile::size() const noexcept {
+    return mappedSize;
+}
+
+grad_aff::ByteSpan grad_aff::MemoryMappedFile::span() const noexcept {
+    return ByteSpan(mappedData, mappedData != nullptr ? mappedSize : 0);
+}
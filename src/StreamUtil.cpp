@@ -1,5 +1,7 @@
 #include "grad_aff/StreamUtil.h"
 
+#include <lzokay.hpp>
+
 /*
     Read
 */
@@ -47,17 +49,6 @@ template int16_t grad_aff::readBytes<int16_t>(std::istream& is);
 // float
 template float_t grad_aff::readBytes<float_t>(std::istream& is);
 
-// https://community.bistudio.com/wiki/raP_File_Format_-_OFP#CompressedInteger
-uint32_t grad_aff::readCompressedInteger(std::istream& is) {
-    auto val = readBytes<uint8_t>(is);
-    auto ret = val;
-    while (val & 0x80) {
-        val = readBytes<uint8_t>(is);
-        ret += (val - 1) * 0x80;
-    }
-    return ret;
-}
-
 template<typename T>
 T grad_aff::peekBytes(std::istream& is) {
     auto pos = is.tellg();
@@ -81,9 +72,7 @@ XYZTriplet grad_aff::readXYZTriplet(std::istream& is) {
 
 TransformMatrix grad_aff::readMatrix(std::istream& is) {
     TransformMatrix matrix = {};
-    for (auto i = 0; i < 4; i++) {
-        matrix[i] = readXYZTriplet(is);
-    }
+    is.read(reinterpret_cast<char*>(matrix.data()), sizeof(TransformMatrix));
     return matrix;
 }
 
@@ -117,14 +106,187 @@ std::string grad_aff::readZeroTerminatedString(std::istream& is) {
     return result;
 }
 
+grad_aff::ByteSpan grad_aff::readSpan(std::istream& is, std::vector<uint8_t>& storage, size_t maxSize) {
+    storage.resize(maxSize);
+    is.read(reinterpret_cast<char*>(storage.data()), storage.size());
+    storage.resize((size_t)is.gcount());
+    is.clear();
+    return ByteSpan(storage);
+}
+
 std::chrono::milliseconds grad_aff::readTimestamp(std::istream& is) {
     return std::chrono::milliseconds(std::chrono::duration<long>(readBytes<uint32_t>(is)));
 }
 
+/*
+    BinaryReader
+*/
+
+uint32_t grad_aff::readBytesAsArmaUShort(BinaryReader& reader) {
+    uint32_t t = 0;
+    reader.readInto(&t, 3);
+    return t;
+}
+
+std::string grad_aff::readString(BinaryReader& reader, int count) {
+    auto view = reader.readView(count);
+    return std::string(reinterpret_cast<const char*>(view.data()), view.size());
+}
+
+std::vector<uint8_t> grad_aff::readBytes(BinaryReader& reader, size_t length) {
+    return reader.readView(length).toVector();
+}
+
+std::string grad_aff::readZeroTerminatedString(BinaryReader& reader) {
+    // like std::getline an unterminated string runs to the end of the buffer
+    auto remaining = reader.getRemaining();
+    auto terminator = static_cast<const uint8_t*>(std::memchr(remaining.data(), 0, remaining.size()));
+    auto length = terminator != nullptr ? (size_t)(terminator - remaining.data()) : remaining.size();
+    std::string result(reinterpret_cast<const char*>(remaining.data()), length);
+    reader.skip(terminator != nullptr ? length + 1 : length);
+    return result;
+}
+
+std::chrono::milliseconds grad_aff::readTimestamp(BinaryReader& reader) {
+    return std::chrono::milliseconds(std::chrono::duration<long>(readBytes<uint32_t>(reader)));
+}
+
+/*
+    Compressed, shared between std::istream and BinaryReader
+*/
+
+namespace {
+    // Compressed arrays store their elements in 4 byte slots
+    template<typename T>
+    std::vector<T> toSlotArray(const std::vector<uint8_t>& bytes) {
+        std::vector<T> retVec;
+        retVec.reserve(bytes.size() / 4);
+
+        for (size_t i = 0; i < bytes.size(); i += 4) {
+            T f;
+            memcpy(&f, &bytes.data()[i], sizeof(T));
+            retVec.push_back(f);
+        }
+        return retVec;
+    }
+
+    // https://community.bistudio.com/wiki/raP_File_Format_-_OFP#CompressedInteger
+    template<typename Source>
+    uint32_t readCompressedIntegerImpl(Source& is) {
+        auto val = grad_aff::readBytes<uint8_t>(is);
+        uint32_t ret = val;
+        while (val & 0x80) {
+            val = grad_aff::readBytes<uint8_t>(is);
+            ret += (val - 1) * 0x80;
+        }
+        return ret;
+    }
+
+    template<typename Source>
+    std::vector<uint8_t> readCompressedLZOLZSSImpl(Source& is, size_t expectedSize, bool useLzo) {
+        if (expectedSize == 0)
+            return {};
+
+        if (useLzo) {
+            return grad_aff::readLZOCompressed<uint8_t>(is, expectedSize).first;
+        }
+        if (expectedSize < 1024) {
+            return grad_aff::readBytes(is, expectedSize);
+        }
+        return grad_aff::readLzssBlock(is, expectedSize);
+    }
+
+    template<typename Source>
+    std::vector<uint8_t> readCompressedImpl(Source& is, size_t expectedSize, bool useCompressionFlag) {
+        if (expectedSize == 0)
+            return {};
+        bool flag = expectedSize >= 1024;
+        if (useCompressionFlag) {
+            flag = grad_aff::readBytes<bool>(is);
+        }
+        if (!flag) {
+            return grad_aff::readBytes(is, expectedSize);
+        }
+        return grad_aff::readLZOCompressed<uint8_t>(is, expectedSize).first;
+    }
+
+    template<typename T, typename Source>
+    std::vector<T> readCompressedArrayImpl(Source& is, size_t expectedSize, bool useCompressionFlag) {
+        if (expectedSize == 0)
+            return {};
+        auto n = grad_aff::readBytes<uint32_t>(is);
+
+        return toSlotArray<T>(readCompressedImpl(is, n * expectedSize, useCompressionFlag));
+    }
+
+    template<typename T, typename Source>
+    std::vector<T> readCompressedArrayOldImpl(Source& is, size_t expectedSize, bool useCompressionFlag) {
+        if (expectedSize == 0)
+            return {};
+        auto n = grad_aff::readBytes<uint32_t>(is);
+
+        return toSlotArray<T>(readCompressedLZOLZSSImpl(is, n * expectedSize, useCompressionFlag));
+    }
+
+    template<typename T, typename Source>
+    std::vector<T> readCompressedFillArrayImpl(Source& is, bool useCompressionFlag) {
+        auto n = grad_aff::readBytes<uint32_t>(is);
+
+        auto defaultFill = grad_aff::readBytes<bool>(is);
+
+        std::vector<T> data;
+        if (defaultFill) {
+            auto fillValue = grad_aff::readBytes<T>(is);
+
+            for (size_t i = 0; i < n; i++)
+            {
+                data.push_back(defaultFill);
+            }
+        }
+        else {
+            data = readCompressedArrayImpl<T>(is, n, useCompressionFlag);
+        }
+        return data;
+    }
+
+    template<typename Source>
+    std::vector<uint8_t> readLzssBlockImpl(Source& is, size_t expectedSize) {
+        if (expectedSize < 1024) {
+            return grad_aff::readBytes(is, expectedSize);
+        }
+        std::vector<uint8_t> result(expectedSize);
+        grad_aff::readLzssSized(is, result, expectedSize);
+        return result;
+    }
+}
+
+uint32_t grad_aff::readCompressedInteger(std::istream& is) {
+    return readCompressedIntegerImpl(is);
+}
+
+uint32_t grad_aff::readCompressedInteger(BinaryReader& reader) {
+    return readCompressedIntegerImpl(reader);
+}
+
 std::pair<std::vector<uint8_t>, size_t> grad_aff::readLZOCompressed(std::istream& is, size_t expectedSize) {
     auto retVec = std::vector<uint8_t>(expectedSize);
     auto retCode = Decompress(is, retVec, expectedSize);
-    return std::make_pair(retVec, retCode);
+    return std::make_pair(std::move(retVec), retCode);
+}
+
+std::pair<std::vector<uint8_t>, size_t> grad_aff::readLZOCompressed(BinaryReader& reader, size_t expectedSize) {
+    auto retVec = std::vector<uint8_t>(expectedSize);
+    auto input = reader.getRemaining();
+    auto retCode = Decompress(input.data(), input.size(), retVec.data(), retVec.size());
+    reader.skip(retCode);
+    return std::make_pair(std::move(retVec), retCode);
+}
+
+size_t grad_aff::skipLZOCompressed(BinaryReader& reader, size_t expectedSize) {
+    auto input = reader.getRemaining();
+    auto compressedSize = ScanCompressed(input.data(), input.size(), expectedSize);
+    reader.skip(compressedSize);
+    return compressedSize;
 }
 
 template <typename T>
@@ -133,142 +295,111 @@ std::pair<std::vector<T>, size_t> grad_aff::readLZOCompressed(std::istream& is,
         return {};
 
     auto bVec = readLZOCompressed(is, expectedSize);
+    return std::make_pair(toSlotArray<T>(bVec.first), bVec.second);
+}
 
-    std::vector<T> retVec;
-    retVec.reserve(sizeof(T) * expectedSize);
-
-    for (size_t i = 0; i < bVec.first.size(); i += 4) {
-        T f;
-        memcpy(&f, &bVec.first.data()[i], sizeof(T));
-        retVec.push_back(f);
-    }
-    return std::make_pair(retVec, bVec.second);
+template <typename T>
+std::pair<std::vector<T>, size_t> grad_aff::readLZOCompressed(BinaryReader& reader, size_t expectedSize) {
+    if (expectedSize == 0)
+        return {};
 
+    auto bVec = readLZOCompressed(reader, expectedSize);
+    return std::make_pair(toSlotArray<T>(bVec.first), bVec.second);
 }
 
 template std::pair<std::vector<float_t>, size_t> grad_aff::readLZOCompressed(std::istream& is, size_t expectedSize);
 template std::pair<std::vector<uint8_t>, size_t> grad_aff::readLZOCompressed(std::istream& is, size_t expectedSize);
 template std::pair<std::vector<uint16_t>, size_t> grad_aff::readLZOCompressed(std::istream& is, size_t expectedSize);
 template std::pair<std::vector<uint32_t>, size_t> grad_aff::readLZOCompressed(std::istream& is, size_t expectedSize);
+template std::pair<std::vector<float_t>, size_t> grad_aff::readLZOCompressed(BinaryReader& reader, size_t expectedSize);
+template std::pair<std::vector<uint8_t>, size_t> grad_aff::readLZOCompressed(BinaryReader& reader, size_t expectedSize);
+template std::pair<std::vector<uint16_t>, size_t> grad_aff::readLZOCompressed(BinaryReader& reader, size_t expectedSize);
+template std::pair<std::vector<uint32_t>, size_t> grad_aff::readLZOCompressed(BinaryReader& reader, size_t expectedSize);
 
 std::vector<uint8_t> grad_aff::readCompressedLZOLZSS(std::istream& is, size_t expectedSize, bool useLzo) {
-    if (expectedSize == 0)
-        return {};
+    return readCompressedLZOLZSSImpl(is, expectedSize, useLzo);
+}
 
-    if (useLzo) {
-        return readLZOCompressed<uint8_t>(is, expectedSize).first;
-    }
-    if (expectedSize < 1024) {
-        return readBytes(is, expectedSize);
-    }
-    return readLzssBlock(is, expectedSize);
+std::vector<uint8_t> grad_aff::readCompressedLZOLZSS(BinaryReader& reader, size_t expectedSize, bool useLzo) {
+    return readCompressedLZOLZSSImpl(reader, expectedSize, useLzo);
 }
 
 std::vector<uint8_t> grad_aff::readCompressed(std::istream& is, size_t expectedSize, bool useCompressionFlag) {
-    if (expectedSize == 0)
-        return {};
-    bool flag = expectedSize >= 1024;
-    if (useCompressionFlag) {
-        flag = readBytes<bool>(is);
-    }
-    if (!flag) {
-        return readBytes(is, expectedSize);
-    }
-    return readLZOCompressed<uint8_t>(is, expectedSize).first;
+    return readCompressedImpl(is, expectedSize, useCompressionFlag);
+}
+
+std::vector<uint8_t> grad_aff::readCompressed(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag) {
+    return readCompressedImpl(reader, expectedSize, useCompressionFlag);
 }
 
 template<typename T>
 std::vector<T> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag) {
+    return readCompressedArrayImpl<T>(is, expectedSize, useCompressionFlag);
+}
 
-    if (expectedSize == 0)
-        return {};
-    auto n = readBytes<uint32_t>(is);
-
-    auto uncomp = readCompressed(is, n * expectedSize, useCompressionFlag);
-    std::vector<T> retVec;
-    retVec.reserve(sizeof(T) * expectedSize);
-
-    for (size_t i = 0; i < uncomp.size(); i += 4) {
-        T f;
-        memcpy(&f, &uncomp.data()[i], sizeof(T));
-        retVec.push_back(f);
-    }
-    return retVec;
+template<typename T>
+std::vector<T> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag) {
+    return readCompressedArrayImpl<T>(reader, expectedSize, useCompressionFlag);
 }
 
 template std::vector<uint32_t> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag);
 template std::vector<uint16_t> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag);
 template std::vector<float_t> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag);
+template std::vector<uint32_t> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+template std::vector<uint16_t> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+template std::vector<float_t> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
 
 template<typename T>
 std::vector<T> grad_aff::readCompressedArrayOld(std::istream& is, size_t expectedSize, bool useCompressionFlag) {
+    return readCompressedArrayOldImpl<T>(is, expectedSize, useCompressionFlag);
+}
 
-    if (expectedSize == 0)
-        return {};
-    auto n = readBytes<uint32_t>(is);
-
-    auto uncomp = readCompressedLZOLZSS(is, n * expectedSize, useCompressionFlag);
-    std::vector<T> retVec;
-    retVec.reserve(sizeof(T) * expectedSize);
-
-    for (size_t i = 0; i < uncomp.size(); i += 4) {
-        T f;
-        memcpy(&f, &uncomp.data()[i], sizeof(T));
-        retVec.push_back(f);
-    }
-    return retVec;
+template<typename T>
+std::vector<T> grad_aff::readCompressedArrayOld(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag) {
+    return readCompressedArrayOldImpl<T>(reader, expectedSize, useCompressionFlag);
 }
 
 template std::vector<uint32_t> grad_aff::readCompressedArrayOld(std::istream& is, size_t expectedSize, bool useCompressionFlag);
 template std::vector<uint16_t> grad_aff::readCompressedArrayOld(std::istream& is, size_t expectedSize, bool useCompressionFlag);
 template std::vector<float_t> grad_aff::readCompressedArrayOld(std::istream& is, size_t expectedSize, bool useCompressionFlag);
+template std::vector<uint32_t> grad_aff::readCompressedArrayOld(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+template std::vector<uint16_t> grad_aff::readCompressedArrayOld(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
+template std::vector<float_t> grad_aff::readCompressedArrayOld(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag);
 
 template<typename T>
 std::vector<T> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag, size_t arrSize) {
-    auto uncomp = readCompressed(is, arrSize * expectedSize, useCompressionFlag);
-    std::vector<T> retVec;
-    retVec.reserve(sizeof(T) * expectedSize);
-
-    for (size_t i = 0; i < uncomp.size(); i += 4) {
-        T f;
-        memcpy(&f, &uncomp.data()[i], sizeof(T));
-        retVec.push_back(f);
-    }
-    return retVec;
+    return toSlotArray<T>(readCompressedImpl(is, arrSize * expectedSize, useCompressionFlag));
 }
+
+template<typename T>
+std::vector<T> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag, size_t arrSize) {
+    return toSlotArray<T>(readCompressedImpl(reader, arrSize * expectedSize, useCompressionFlag));
+}
+
 template std::vector<uint32_t> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag, size_t arrSize);
 template std::vector<float_t> grad_aff::readCompressedArray(std::istream& is, size_t expectedSize, bool useCompressionFlag, size_t arrSize);
+template std::vector<uint32_t> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag, size_t arrSize);
+template std::vector<float_t> grad_aff::readCompressedArray(BinaryReader& reader, size_t expectedSize, bool useCompressionFlag, size_t arrSize);
 
 template<typename T>
 std::vector<T> grad_aff::readCompressedFillArray(std::istream& is, bool useCompressionFlag) {
-    auto n = readBytes<uint32_t>(is);
-
-    auto defaultFill = readBytes<bool>(is);
-
-    std::vector<T> data;
-    if (defaultFill) {
-        auto fillValue = readBytes<T>(is);
+    return readCompressedFillArrayImpl<T>(is, useCompressionFlag);
+}
 
-        for (size_t i = 0; i < n; i++)
-        {
-            data.push_back(defaultFill);
-        }
-    }
-    else {
-        data = readCompressedArray<T>(is, n, useCompressionFlag);
-    }
-    return data;
+template<typename T>
+std::vector<T> grad_aff::readCompressedFillArray(BinaryReader& reader, bool useCompressionFlag) {
+    return readCompressedFillArrayImpl<T>(reader, useCompressionFlag);
 }
 
 template std::vector<uint32_t> grad_aff::readCompressedFillArray(std::istream& is, bool useCompressionFlag);
+template std::vector<uint32_t> grad_aff::readCompressedFillArray(BinaryReader& reader, bool useCompressionFlag);
 
 std::vector<uint8_t> grad_aff::readLzssBlock(std::istream& is, size_t expectedSize) {
-    if (expectedSize < 1024) {
-        return readBytes(is, expectedSize);
-    }
-    std::vector<uint8_t> result(expectedSize);
-    readLzssSized(is, result, expectedSize, false);
-    return result;
+    return readLzssBlockImpl(is, expectedSize);
+}
+
+std::vector<uint8_t> grad_aff::readLzssBlock(BinaryReader& reader, size_t expectedSize) {
+    return readLzssBlockImpl(reader, expectedSize);
 }
 
 /*
@@ -310,218 +441,298 @@ void grad_aff::writeTimestamp(std::ostream& ofs, std::chrono::milliseconds milli
     writeBytes<uint32_t>(ofs, milliseconds.count());
 }
 
-size_t grad_aff::readLzssFile(std::istream& is, std::vector<uint8_t>& out)
-{
-    std::streampos inSize = 0;
-    inSize = is.tellg();
-    is.seekg(0, std::ios::end);
-    inSize = is.tellg() - inSize;
-
-    is.seekg(0);
-
-    const int slidingWindowSize = 4096;
-    const int bestMatch = 18;
-    const int threshold = 2;
-
-    std::vector<uint8_t> textBuffer(slidingWindowSize + bestMatch - 1);
-    out.reserve(inSize * 4);
+size_t grad_aff::writeLZOCompressed(std::ostream& ofs, ByteSpan data) {
+    std::vector<uint8_t> compressed(lzokay::compress_worst_size(data.size()));
+    size_t compressedSize = 0;
+    auto error = lzokay::compress(data.data(), data.size(), compressed.data(), compressed.size(), compressedSize);
+    if (error < lzokay::EResult::Success) {
+        throw std::runtime_error("LZO Compression failed");
+    }
+    ofs.write(reinterpret_cast<const char*>(compressed.data()), compressedSize);
+    return compressedSize;
+}
 
-    int textBufferIndex = 0, checkSum = 0, flags = 0;
-    textBufferIndex = slidingWindowSize - bestMatch;
-    while (is.tellg() < (inSize - static_cast<std::streampos>(4)))
-    {
-        if (((flags >>= 1) & 256) == 0)
-        {
-            flags = readBytes<uint8_t>(is) | 0xff00;
+size_t grad_aff::decodeLzss(ByteSpan in, std::vector<uint8_t>& out, size_t expectedSize)
+{
+    const size_t slidingWindowSize = 4096;
+    const size_t bestMatch = 18;
+    const size_t threshold = 2;
+
+    const bool sizeKnown = expectedSize > 0;
+    const uint8_t* ip = in.data();
+    const uint8_t* inEnd = ip + in.size();
+    // without a size the tokens end where the checksum starts
+    const uint8_t* tokenEnd = sizeKnown ? inEnd : ip + (in.size() > 4 ? in.size() - 4 : 0);
+
+    out.resize(sizeKnown ? expectedSize : std::max<size_t>(in.size() * 4, 64));
+    uint8_t* op = out.data();
+    size_t outPos = 0;
+
+    auto ensureOutput = [&](size_t length) {
+        if (outPos + length > out.size()) {
+            if (sizeKnown) {
+                throw std::runtime_error("LZSS overflow");
+            }
+            out.resize(std::max(out.size() * 2, outPos + length));
+            op = out.data();
         }
-        if ((flags & 1) != 0)
-        {
-            auto data = readBytes<uint8_t>(is);
-            checkSum += data;
-
-            out.push_back(data);
+    };
 
-            textBuffer[textBufferIndex] = data;
-            textBufferIndex++; textBufferIndex &= (slidingWindowSize - 1);
+    uint32_t flags = 0;
+    while (sizeKnown ? outPos < expectedSize : ip < tokenEnd) {
+        if (((flags >>= 1) & 256) == 0) {
+            if (ip >= inEnd) {
+                throw std::runtime_error("LZSS input truncated");
+            }
+            flags = *ip++ | 0xff00;
         }
-        else
-        {
-            int pos = readBytes<uint8_t>(is);
-            int length = readBytes<uint8_t>(is);
-            pos |= (length & 0xf0) << 4; length &= 0x0f; length += threshold;
 
-            int bufferPos = textBufferIndex - pos;
-            int bufferLength = length + bufferPos;
-
-            for (; bufferPos <= bufferLength; bufferPos++)
-            {
-                auto data = textBuffer[bufferPos & (slidingWindowSize - 1)];
-                checkSum += data;
-
-                out.push_back(data);
+        if ((flags & 1) != 0) {
+            if (ip >= inEnd) {
+                throw std::runtime_error("LZSS input truncated");
+            }
+            ensureOutput(1);
+            op[outPos++] = *ip++;
+        }
+        else {
+            if (inEnd - ip < 2) {
+                throw std::runtime_error("LZSS input truncated");
+            }
+            size_t distance = ip[0] | ((ip[1] & 0xf0) << 4);
+            size_t length = (ip[1] & 0x0f) + threshold + 1;
+            ip += 2;
+            // distance 0 wraps around to the oldest byte of the window
+            if (distance == 0) {
+                distance = slidingWindowSize;
+            }
 
-                textBuffer[textBufferIndex] = data;
-                textBufferIndex++; textBufferIndex &= (slidingWindowSize - 1);
+            ensureOutput(length);
+            auto dst = op + outPos;
+            if (distance > outPos) {
+                // the window starts out filled with spaces, followed by zeros in its last slots
+                for (size_t i = 0; i < length; i++) {
+                    auto srcPos = (int64_t)(outPos + i) - (int64_t)distance;
+                    if (srcPos >= 0) {
+                        dst[i] = op[srcPos];
+                    }
+                    else {
+                        dst[i] = srcPos >= -(int64_t)(slidingWindowSize - bestMatch) ? ' ' : 0;
+                    }
+                }
+            }
+            else if (distance >= length) {
+                std::memcpy(dst, dst - distance, length);
+            }
+            else {
+                // overlapping match repeats the last distance bytes
+                for (size_t i = 0; i < length; i++) {
+                    dst[i] = dst[i - distance];
+                }
             }
+            outPos += length;
         }
     }
 
-    auto readChecksum = readBytes<int32_t>(is);
-    if (checkSum == readChecksum) {
-        return inSize;
+    out.resize(outPos);
+    return ip - in.data();
+}
+
+int32_t grad_aff::lzssChecksum(ByteSpan data, bool useSignedChecksum)
+{
+    int32_t checkSum = 0;
+    if (useSignedChecksum) {
+        for (auto value : data) {
+            checkSum += (int8_t)value;
+        }
     }
     else {
-        return -1;
+        for (auto value : data) {
+            checkSum += value;
+        }
     }
+    return checkSum;
 }
 
-
-size_t grad_aff::readLzss(std::vector<uint8_t> in, std::vector<uint8_t>& out)
+size_t grad_aff::readLzss(ByteSpan in, std::vector<uint8_t>& out, size_t expectedSize, bool useSignedChecksum)
 {
-    auto inSize = in.size();
-    auto inIndex = 0;
-
-    const int slidingWindowSize = 4096;
-    const int bestMatch = 18;
-    const int threshold = 2;
-
-    std::vector<uint8_t> textBuffer(slidingWindowSize + bestMatch - 1);
-    out.reserve(inSize * 4);
+    auto consumed = decodeLzss(in, out, expectedSize);
+    if (in.size() - consumed < 4) {
+        throw std::runtime_error("LZSS input truncated");
+    }
 
-    int textBufferIndex = 0, checkSum = 0, flags = 0;
-    textBufferIndex = slidingWindowSize - bestMatch;
-    while (inIndex < (inSize - static_cast<std::streampos>(4)))
-    {
-        if (((flags >>= 1) & 256) == 0)
-        {
-            flags = in[inIndex] | 0xff00;
-            inIndex++;
-        }
-        if ((flags & 1) != 0)
-        {
-            auto data = in[inIndex];
-            inIndex++;
-            checkSum += data;
+    int32_t readChecksum;
+    std::memcpy(&readChecksum, in.data() + consumed, 4);
+    if (lzssChecksum(ByteSpan(out), useSignedChecksum) != readChecksum) {
+        return -1;
+    }
+    return consumed + 4;
+}
 
-            out.push_back(data);
+size_t grad_aff::readLzssFile(std::istream& is, std::vector<uint8_t>& out)
+{
+    // the whole stream is one compressed file
+    is.clear();
+    is.seekg(0, std::ios::end);
+    size_t inSize = is.tellg();
+    is.seekg(0);
 
-            textBuffer[textBufferIndex] = data;
-            textBufferIndex++; textBufferIndex &= (slidingWindowSize - 1);
-        }
-        else
-        {
-            int pos = in[inIndex];
-            inIndex++;
-            int length = in[inIndex];
-            inIndex++;
-            pos |= (length & 0xf0) << 4; length &= 0x0f; length += threshold;
-
-            int bufferPos = textBufferIndex - pos;
-            int bufferLength = length + bufferPos;
-
-            for (; bufferPos <= bufferLength; bufferPos++)
-            {
-                auto data = textBuffer[bufferPos & (slidingWindowSize - 1)];
-                checkSum += data;
+    std::vector<uint8_t> storage;
+    auto in = readSpan(is, storage, inSize);
+    is.seekg(0, std::ios::end);
+    return readLzss(in, out, 0, false);
+}
 
-                out.push_back(data);
+size_t grad_aff::readLzss(const std::vector<uint8_t>& in, std::vector<uint8_t>& out)
+{
+    return readLzss(ByteSpan(in), out, 0, false);
+}
 
-                textBuffer[textBufferIndex] = data;
-                textBufferIndex++; textBufferIndex &= (slidingWindowSize - 1);
-            }
-        }
+size_t grad_aff::readLzssSized(std::istream& is, std::vector<uint8_t>& out, size_t expectedSize)
+{
+    out.resize(expectedSize);
+    if (expectedSize <= 0u)
+    {
+        return 0u;
     }
+    size_t position = is.tellg();
 
-    int readChecksum;
-    std::memcpy(&readChecksum, &in[inIndex], 4);
+    // every 8 tokens take a flag byte and each token yields at least one byte
+    std::vector<uint8_t> storage;
+    auto in = readSpan(is, storage, expectedSize + expectedSize / 8 + 1 + 4);
+    auto consumed = decodeLzss(in, out, expectedSize);
 
-    if (checkSum == readChecksum) {
-        return inSize;
-    }
-    else {
-        return -1;
-    }
+    // the trailing checksum is skipped, these blocks were never verified
+    is.seekg(position + consumed + 4);
+    return consumed + 4;
 }
 
-size_t grad_aff::readLzssSized(std::istream& is, std::vector<uint8_t>& out, size_t expectedSize, bool useSignedChecksum)
+size_t grad_aff::readLzssSized(BinaryReader& reader, std::vector<uint8_t>& out, size_t expectedSize)
 {
-    std::vector<uint8_t> arr(4113);
     out.resize(expectedSize);
     if (expectedSize <= 0u)
     {
         return 0u;
     }
-    size_t position = is.tellg();
-    size_t num = expectedSize;
-    int num2 = 0;
-    int num3 = 0;
-    for (int i = 0; i < 4078; i++)
-    {
-        arr[i] = ' ';
-    }
-    int num4 = 4078;
-    int num5 = 0;
-    while (num > 0u)
-    {
-        if (((num5 >>= 1) & 256) == 0)
-        {
-            int num6 = readBytes<uint8_t>(is);
-            num5 = (num6 | 65280);
+
+    auto consumed = decodeLzss(reader.getRemaining(), out, expectedSize);
+    // the trailing checksum is skipped, these blocks were never verified
+    reader.skip(consumed + 4);
+    return consumed + 4;
+}
+
+size_t grad_aff::writeLzss(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, int maxChainLength)
+{
+    const int slidingWindowSize = 4096;
+    const int bestMatch = 18;
+    const int threshold = 2;
+    const size_t minMatch = threshold + 1;
+    const int hashBits = 14;
+
+    const auto inSize = in.size();
+    out.clear();
+    out.reserve(inSize + inSize / 8 + 5);
+
+    // hash chains over the window: head per hash of the next 3 bytes, prev per window slot
+    const size_t noPos = SIZE_MAX;
+    std::vector<size_t> head((size_t)1 << hashBits, noPos);
+    std::vector<size_t> prev(slidingWindowSize, noPos);
+
+    auto hash = [&in](size_t pos) {
+        uint32_t key = in[pos] | (in[pos + 1] << 8) | (in[pos + 2] << 16);
+        return (key * 2654435761u) >> (32 - hashBits);
+    };
+
+    auto insert = [&](size_t pos) {
+        if (pos + minMatch <= inSize) {
+            auto h = hash(pos);
+            prev[pos & (slidingWindowSize - 1)] = head[h];
+            head[h] = pos;
         }
-        if ((num5 & 1) != 0)
-        {
-            int num6 = readBytes<uint8_t>(is);
-            if (useSignedChecksum)
-            {
-                num3 += (int)((int8_t)num6);
+    };
+
+    struct Match {
+        size_t length = 0;
+        size_t distance = 0;
+    };
+
+    auto findMatch = [&](size_t pos) {
+        Match best;
+        if (pos + minMatch > inSize) {
+            return best;
+        }
+        auto maxLength = std::min<size_t>(bestMatch, inSize - pos);
+        auto candidate = head[hash(pos)];
+        for (int chain = 0; candidate != noPos && pos - candidate < slidingWindowSize && chain < maxChainLength; chain++) {
+            size_t length = 0;
+            while (length < maxLength && in[candidate + length] == in[pos + length]) {
+                length++;
             }
-            else
-            {
-                num3 += (int)((uint8_t)num6);
+            if (length > best.length) {
+                best.length = length;
+                best.distance = pos - candidate;
+                if (length == maxLength) {
+                    break;
+                }
             }
-            out[num2++] = (uint8_t)num6;
-            num -= 1u;
-            arr[num4] = (char)num6;
-            num4++;
-            num4 &= 4095;
+            candidate = prev[candidate & (slidingWindowSize - 1)];
         }
-        else
-        {
-            int i = readBytes<uint8_t>(is);
-            int num7 = readBytes<uint8_t>(is);
-            i |= (num7 & 240) << 4;
-            num7 &= 15;
-            num7 += 2;
-            int j = num4 - i;
-            int num8 = num7 + j;
-            if ((long)(num7 + 1) > (long)((size_t)num))
-            {
-                throw std::runtime_error("LZSS overflow");
+        if (best.length < minMatch) {
+            best.length = 0;
+        }
+        return best;
+    };
+
+    size_t flagPos = 0;
+    int flagBit = 8;
+    auto beginToken = [&](bool isLiteral) {
+        if (flagBit == 8) {
+            flagPos = out.size();
+            out.push_back(0);
+            flagBit = 0;
+        }
+        if (isLiteral) {
+            out[flagPos] |= (1 << flagBit);
+        }
+        flagBit++;
+    };
+
+    size_t pos = 0;
+    auto match = findMatch(pos);
+    while (pos < inSize) {
+        insert(pos);
+        if (match.length > 0) {
+            // lazy matching, prefer a literal if the next position has a longer match
+            auto next = findMatch(pos + 1);
+            if (next.length > match.length) {
+                beginToken(true);
+                out.push_back(in[pos]);
+                pos++;
+                match = next;
+                continue;
             }
-            while (j <= num8)
-            {
-                int num6 = (int)((uint8_t)arr[j & 4095]);
-                if (useSignedChecksum)
-                {
-                    num3 += (int)((int8_t)num6);
-                }
-                else
-                {
-                    num3 += (int)((uint8_t)num6);
-                }
-                out[num2++] = (uint8_t)num6;
-                num -= 1u;
-                arr[num4] = (char)num6;
-                num4++;
-                num4 &= 4095;
-                j++;
+
+            beginToken(false);
+            out.push_back(match.distance & 0xff);
+            out.push_back(((match.distance >> 4) & 0xf0) | (match.length - minMatch));
+            for (size_t i = pos + 1; i < pos + match.length; i++) {
+                insert(i);
             }
+            pos += match.length;
+        }
+        else {
+            beginToken(true);
+            out.push_back(in[pos]);
+            pos++;
         }
+        match = findMatch(pos);
     }
-    std::vector<uint8_t> arr2 = readBytes(is, 4);
-    //if (BitConverter.ToInt32(array2, 0) != num3)
-    //{
-    //    //throw new ArgumentException("Checksum mismatch");
-    //}
-    return (size_t)is.tellg() - position;
+
+    int32_t checkSum = 0;
+    for (auto data : in) {
+        checkSum += data;
+    }
+    out.resize(out.size() + 4);
+    std::memcpy(&out[out.size() - 4], &checkSum, 4);
+
+    return out.size();
 }
@@ -0,0 +1,120 @@
+#include "grad_aff/ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+    // pool and queue of the worker running on this thread
+    thread_local const grad_aff::ThreadPool* currentPool = nullptr;
+    thread_local size_t currentQueue = 0;
+}
+
+grad_aff::ThreadPool::ThreadPool(size_t threadCount) {
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i <= threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+grad_aff::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+grad_aff::ThreadPool& grad_aff::ThreadPool::global() {
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return pool;
+}
+
+size_t grad_aff::ThreadPool::size() const noexcept {
+    return threads.size();
+}
+
+void grad_aff::ThreadPool::submit(std::function<void()> task) {
+    auto& queue = currentPool == this ? *queues[currentQueue] : *queues.back();
+    // counted first so queued never drops below the real number of tasks
+    queued++;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    // taking the lock orders the increment before a worker checks it and goes to sleep
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool grad_aff::ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    if (!popTask(currentPool == this ? currentQueue : queues.size() - 1, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+bool grad_aff::ThreadPool::popTask(size_t queueIndex, std::function<void()>& task) {
+    if (queued == 0) {
+        return false;
+    }
+    // newest task of the own queue, it's still warm in the cache
+    if (queueIndex < threads.size()) {
+        auto& own = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    // then the oldest of the shared queue and of the other workers
+    auto takeOldest = [this, &task](Queue& queue) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        queued--;
+        return true;
+    };
+    if (takeOldest(*queues.back())) {
+        return true;
+    }
+    for (size_t i = 1; i <= threads.size(); i++) {
+        auto victim = (queueIndex + i) % threads.size();
+        if (victim != queueIndex && takeOldest(*queues[victim])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void grad_aff::ThreadPool::workerLoop(size_t queueIndex) {
+    currentPool = this;
+    currentQueue = queueIndex;
+    std::function<void()> task;
+    while (true) {
+        if (popTask(queueIndex, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
@@ -1,211 +1,185 @@
 #include "grad_aff/a3lzo.h"
 
-// Based on https://community.bistudio.com/wiki/Compressed_LZO_File_Format
-size_t grad_aff::Decompress(std::istream& i, std::vector<uint8_t>& output, size_t expectedSize)
-{
-    auto startPos = i.tellg();
-    std::vector<uint8_t>::iterator op;
-    unsigned int t = 0;
-    std::vector<uint8_t>::iterator m_pos;
-
-    auto op_end = output.end();
-    op = output.begin();
+#include <stdexcept>
 
-    if (peekBytes<uint8_t>(i) > 17)
+// Based on https://community.bistudio.com/wiki/Compressed_LZO_File_Format
+// lzokay needs the exact compressed size, which Arma files don't store, so the stream is decoded here
+namespace {
+    // Without Write only the stream is walked, output is never touched and may be null
+    template<bool Write>
+    size_t decodeLzo(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize)
     {
-        t = readBytes<uint8_t>(i) - 17U;
-        if (t < 4) goto match_next;
-
-        assert(t > 0);
-        if ((op_end - op) < (t)) {
-            throw std::overflow_error("Output Overun");
-        }
-        do *op++ = readBytes<uint8_t>(i); while (--t > 0);
-        goto first_literal_run;
-    }
-
-B_3:
-    t = (size_t)readBytes<uint8_t>(i);
-    if (t >= 16) goto match;
+        const uint8_t* ip = input;
+        const uint8_t* const ipEnd = input + inputSize;
+        size_t produced = 0;
+        size_t t = 0;
+        size_t distance = 0;
+        size_t length = 0;
+
+        auto needInput = [&](size_t n) {
+            if ((size_t)(ipEnd - ip) < n) {
+                throw std::underflow_error("Input Overrun");
+            }
+        };
+        auto needOutput = [&](size_t n) {
+            if (outputSize - produced < n) {
+                throw std::overflow_error("Output Overrun");
+            }
+        };
+        auto copyLiterals = [&](size_t n) {
+            needInput(n);
+            needOutput(n);
+            if constexpr (Write) {
+                std::memcpy(output + produced, ip, n);
+            }
+            produced += n;
+            ip += n;
+        };
+        auto copyMatch = [&](size_t matchDistance, size_t matchLength) {
+            if (matchDistance == 0 || matchDistance > produced) {
+                throw std::underflow_error("Lookbehind Overrun");
+            }
+            needOutput(matchLength);
+            if constexpr (Write) {
+                uint8_t* op = output + produced;
+                const uint8_t* mPos = op - matchDistance;
+                if (matchDistance >= matchLength) {
+                    std::memcpy(op, mPos, matchLength);
+                }
+                else {
+                    // overlapping match repeats the last matchDistance bytes
+                    for (size_t n = 0; n < matchLength; n++) {
+                        op[n] = mPos[n];
+                    }
+                }
+            }
+            produced += matchLength;
+        };
+        // zero bytes extend a length by 255 each, the final byte is added on top of base
+        auto readRunLength = [&](size_t base) {
+            needInput(1);
+            size_t runLength = 0;
+            while (*ip == 0) {
+                runLength += 255;
+                ip++;
+                needInput(1);
+            }
+            return runLength + base + *ip++;
+        };
 
-    if (t == 0)
-    {
-        while (peekBytes<uint8_t>(i) == 0)
+        needInput(1);
+        if (*ip > 17)
         {
-            t += 255;
-            i.seekg(1, std::ios_base::cur);
+            t = *ip++ - 17U;
+            if (t < 4) goto match_next;
+            copyLiterals(t);
+            goto first_literal_run;
         }
-        t += 15U + readBytes<uint8_t>(i);
-    }
-    assert(t > 0);
-    if ((op_end - op) < (t + 3)) {
-        throw std::overflow_error("Output Overrun");
-    }
 
-    *op++ = readBytes<uint8_t>(i);
-    *op++ = readBytes<uint8_t>(i);
-    *op++ = readBytes<uint8_t>(i);
-    *op++ = readBytes<uint8_t>(i);
-    if (--t > 0)
-    {
-        if (t >= 4)
+    literal_run:
+        needInput(1);
+        t = *ip++;
+        if (t >= 16) goto match;
+
+        if (t == 0)
         {
-            do
-            {
-                *op++ = readBytes<uint8_t>(i);
-                *op++ = readBytes<uint8_t>(i);
-                *op++ = readBytes<uint8_t>(i);
-                *op++ = readBytes<uint8_t>(i);
-                t -= 4;
-            } while (t >= 4);
-            if (t > 0) do *op++ = readBytes<uint8_t>(i); while (--t > 0);
+            t = readRunLength(15);
         }
-        else
-            do *op++ = readBytes<uint8_t>(i); while (--t > 0);
-    }
-
-first_literal_run:
-    t = readBytes<uint8_t>(i);
-    if (t >= 16) goto match;
+        copyLiterals(t + 3);
 
-    m_pos = op - (1 + M2_MAX_OFFSET);
-    m_pos -= t >> 2;
-    m_pos -= readBytes<uint8_t>(i) << 2;
+    first_literal_run:
+        needInput(1);
+        t = *ip++;
+        if (t >= 16) goto match;
 
-    if (m_pos < output.begin() || m_pos >= op) {
-        throw std::underflow_error("Lookbeding Overrun");
-    }
-    if ((op_end - op) < (3)) {
-        throw std::overflow_error("Output Overrun");
-    }
-    *op++ = *m_pos++; *op++ = *m_pos++; *op++ = *m_pos;
+        needInput(1);
+        distance = 1 + M2_MAX_OFFSET + (t >> 2) + (*ip++ << 2);
+        copyMatch(distance, 3);
 
-    goto match_done;
+        goto match_done;
 
-match:
-    if (t >= 64)
-    {
-        m_pos = op - 1;
-        m_pos -= (t >> 2) & 7;
-        m_pos -= readBytes<uint8_t>(i) << 3;
-        t = (t >> 5) - 1;
-        if (m_pos < output.begin() || m_pos >= op) {
-            throw std::underflow_error("Lookbeding Overrun");
-        }
-        assert(t > 0);
-        if ((op_end - op) < (t + 2)) {
-            throw std::overflow_error("Output Overrun");
+    match:
+        if (t >= 64)
+        {
+            needInput(1);
+            distance = 1 + ((t >> 2) & 7) + (*ip++ << 3);
+            length = (t >> 5) + 1;
         }
-        goto copy_match;
-    }
-    else if (t >= 32)
-    {
-        t &= 31;
-        if (t == 0)
+        else if (t >= 32)
         {
-            while (peekBytes<uint8_t>(i) == 0)
+            t &= 31;
+            if (t == 0)
             {
-                t += 255;
-                i.seekg(1, std::ios_base::cur);
+                t = readRunLength(31);
             }
-            t += 31U + readBytes<uint8_t>(i);
+            needInput(2);
+            distance = 1 + (ip[0] >> 2) + (ip[1] << 6);
+            ip += 2;
+            length = t + 2;
         }
-
-        m_pos = op - 1;
-        m_pos -= (readBytes<uint8_t>(i, 0) >> 2) + (readBytes<uint8_t>(i, 1) << 6);
-
-        i.seekg(2, std::ios_base::cur);
-    }
-    else if (t >= 16)
-    {
-        m_pos = op;
-        m_pos -= (t & 8) << 11;
-
-        t &= 7;
-        if (t == 0)
+        else if (t >= 16)
         {
-            while (peekBytes<uint8_t>(i) == 0)
+            distance = (t & 8) << 11;
+            t &= 7;
+            if (t == 0)
             {
-                t += 255;
-                i.seekg(1, std::ios_base::cur);
+                t = readRunLength(7);
             }
-            t += 7U + readBytes<uint8_t>(i);
-        }
-
-        m_pos -= (readBytes<uint8_t>(i, 0) >> 2) + (readBytes<uint8_t>(i, 1) << 6);
-
-        i.seekg(2, std::ios_base::cur);
+            needInput(2);
+            distance += (ip[0] >> 2) + (ip[1] << 6);
+            ip += 2;
 
-        if (m_pos == op)
-        {
-            assert(t == 1);
-            if (m_pos != op_end) {
-                throw std::overflow_error("Output Overrun");
+            // end of stream marker
+            if (distance == 0)
+            {
+                if (produced != outputSize) {
+                    throw std::overflow_error("Output Overrun");
+                }
+                return ip - input;
             }
-            return i.tellg() - startPos;
+            distance += 0x4000;
+            length = t + 2;
         }
-        m_pos -= 0x4000;
-    }
-    else
-    {
-        m_pos = op - 1;
-        m_pos -= t >> 2;
-        m_pos -= readBytes<uint8_t>(i) << 2;
-
-        if (m_pos < output.begin() || m_pos >= op) {
-            throw std::underflow_error("Lookbehind Overrun");
-        }
-        if ((op_end - op) < (2)) {
-            throw std::overflow_error("Output Overrun");
+        else
+        {
+            needInput(1);
+            distance = 1 + (t >> 2) + (*ip++ << 2);
+            length = 2;
         }
-        *op++ = *m_pos++; *op++ = *m_pos;
-        goto match_done;
-    }
+        copyMatch(distance, length);
 
-    if (m_pos < output.begin() || m_pos >= op) {
-        throw std::underflow_error("Lookbehind Overrun");
-    }
-    assert(t > 0);
-    if ((op_end - op) < (t + 2)) {
-        throw std::overflow_error("Output Overrun");
-    }
+    match_done:
+        t = ip[-2] & 3U;
+        if (t == 0) goto literal_run;
 
-    if (t >= 2 * 4 - (3 - 1) && (op - m_pos) >= 4)
-    {
-        *op++ = *m_pos++;
-        *op++ = *m_pos++;
-        *op++ = *m_pos++;
-        *op++ = *m_pos++;
-        t -= 4 - (3 - 1);
-        do
-        {
-            *op++ = *m_pos++;
-            *op++ = *m_pos++;
-            *op++ = *m_pos++;
-            *op++ = *m_pos++;
-            t -= 4;
-        } while (t >= 4);
-        if (t > 0) do *op++ = *m_pos++; while (--t > 0);
-        goto match_done;
+    match_next:
+        copyLiterals(t);
+
+        needInput(1);
+        t = *ip++;
+        goto match;
     }
+}
 
-copy_match:
-    *op++ = *m_pos++; *op++ = *m_pos++;
-    do *op++ = *m_pos++; while (--t > 0);
+size_t grad_aff::Decompress(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize)
+{
+    return decodeLzo<true>(input, inputSize, output, outputSize);
+}
 
-match_done:
-    t = readBytes<uint8_t>(i, -2) & 3U;
-    if (t == 0) goto B_3;
+size_t grad_aff::ScanCompressed(const uint8_t* input, size_t inputSize, size_t outputSize)
+{
+    return decodeLzo<false>(input, inputSize, nullptr, outputSize);
+}
 
-match_next:
-    assert(t > 0 && t < 4);
-    if ((op_end - op) < (t)) {
-        throw std::overflow_error("Output Overrun");
-    }
+size_t grad_aff::Decompress(std::istream& i, std::vector<uint8_t>& output, size_t expectedSize)
+{
+    auto startPos = i.tellg();
 
-    *op++ = readBytes<uint8_t>(i);
-    if (t > 1) { *op++ = readBytes<uint8_t>(i); if (t > 2) { *op++ = readBytes<uint8_t>(i); } }
+    // the compressed size is unknown, take as much as the worst case could need
+    std::vector<uint8_t> storage;
+    auto input = readSpan(i, storage, expectedSize + expectedSize / 16 + 64 + 3);
+    auto consumed = Decompress(input.data(), input.size(), output.data(), output.size());
 
-    t = readBytes<uint8_t>(i);
-    goto match;
+    i.seekg(startPos + (std::streamoff)consumed);
+    return consumed;
 }
@@ -2,18 +2,18 @@
 
 #include <algorithm>
 grad_aff::Odol::Odol(std::string filename) {
-    this->is = std::make_shared<std::ifstream>(filename, std::ios::binary);
+    this->reader = BinaryReader::fromFile(filename);
 };
 
 grad_aff::Odol::Odol(std::vector<uint8_t> data) {
-    this->is = std::make_shared<std::stringstream>(std::string(data.begin(), data.end()));
+    this->reader = BinaryReader(std::move(data));
 }
 
 void grad_aff::Odol::readOdol(bool withLods) {
-    is->seekg(0);
-    signature = readString(*is, 4);
+    reader.seek(0);
+    signature = readString(reader, 4);
     assert(signature == "ODOL");
-    version = readBytes<uint32_t>(*is);
+    version = readBytes<uint32_t>(reader);
 
     if (version < 40) {
         throw std::runtime_error("non arma odols are not supported!");
@@ -32,31 +32,26 @@ void grad_aff::Odol::readOdol(bool withLods) {
     }
 
     if (version == 58) {
-        auto p3dPrefix = readZeroTerminatedString(*is);
+        auto p3dPrefix = readZeroTerminatedString(reader);
     }
 
     if (version >= 59) {
-        auto appId = readBytes<uint32_t>(*is);
+        auto appId = readBytes<uint32_t>(reader);
     }
     if(version >= 58) {
-        auto muzzleFlashString = readZeroTerminatedString(*is);
+        auto muzzleFlashString = readZeroTerminatedString(reader);
     }
 
     readModelInfo();
     readAnimations();
 
 
-    for (auto i = 0; i < modelInfo.nLods; i++) {
-        startAddressOfLods.push_back(readBytes<uint32_t>(*is));
-    }
-
-    for (auto i = 0; i < modelInfo.nLods; i++) {
-        endAddressOfLods.push_back(readBytes<uint32_t>(*is));
-    }
+    startAddressOfLods = readArray<uint32_t>(reader, modelInfo.nLods);
+    endAddressOfLods = readArray<uint32_t>(reader, modelInfo.nLods);
 
     std::vector<bool> useDefault = {};
     for (auto i = 0; i < modelInfo.nLods; i++) {
-        useDefault.push_back(readBytes<bool>(*is));
+        useDefault.push_back(readBytes<bool>(reader));
     }
 
     auto useDefaultFalseCount = 0;
@@ -74,18 +69,18 @@ void grad_aff::Odol::readOdol(bool withLods) {
             continue;
         }
 
-        faceData.headerFaceCount = readBytes<int32_t>(*is);
-        faceData.color = readBytes<uint32_t>(*is);
-        faceData.special = readBytes<uint32_t>(*is);
-        faceData.orHints = readBytes<uint32_t>(*is);
+        faceData.headerFaceCount = readBytes<int32_t>(reader);
+        faceData.color = readBytes<uint32_t>(reader);
+        faceData.special = readBytes<uint32_t>(reader);
+        faceData.orHints = readBytes<uint32_t>(reader);
 
         if (version >= 39) {
-            faceData.hasSkeleton = readBytes<bool>(*is);
+            faceData.hasSkeleton = readBytes<bool>(reader);
         }
 
         if (version >= 51) {
-            faceData.nVertices = readBytes<uint32_t>(*is);
-            faceData.faceArea = readBytes<float_t>(*is);
+            faceData.nVertices = readBytes<uint32_t>(reader);
+            faceData.faceArea = readBytes<float_t>(reader);
         }
 
         faceDefaults.push_back(faceData);
@@ -94,7 +89,7 @@ void grad_aff::Odol::readOdol(bool withLods) {
     if (withLods) {
         this->lods.clear();
         for (auto i = 0; i < modelInfo.nLods; i++) {
-            is->seekg(startAddressOfLods[i]);
+            reader.seek(startAddressOfLods[i]);
             this->lods.push_back(readLod());
             lods.back().lodType = getLodType(modelInfo.lodTypes[i]);
         }
@@ -107,7 +102,7 @@ void grad_aff::Odol::peekLodTypes() {
 
     this->lods.clear();
     for (auto i = 0; i < modelInfo.nLods; i++) {
-        is->seekg(startAddressOfLods[i]);
+        reader.seek(startAddressOfLods[i]);
         this->lods.push_back(readLod());
         lods.back().lodType = getLodType(modelInfo.lodTypes[i]);
     }
@@ -117,227 +112,215 @@ ODOLv4xLod grad_aff::Odol::readLod(uint32_t index) {
     if (modelInfo.nLods == 0)
         readOdol(false);
 
-    is->seekg(startAddressOfLods[index]);
+    reader.seek(startAddressOfLods[index]);
     ODOLv4xLod lod = readLod();
     lod.lodType = getLodType(modelInfo.lodTypes[index]);
     return lod;
 }
 
 void grad_aff::Odol::readModelInfo(bool peekLodType) {
-    modelInfo.nLods = readBytes<uint32_t>(*is);
+    modelInfo.nLods = readBytes<uint32_t>(reader);
 
     modelInfo.lodTypes.reserve(modelInfo.nLods);
     for (size_t i = 0; i < modelInfo.nLods; i++) {
-        modelInfo.lodTypes.push_back(readBytes<float_t>(*is));
+        modelInfo.lodTypes.push_back(readBytes<float_t>(reader));
     }
 
     if (peekLodType)
         return;
 
-    modelInfo.index = readBytes<uint32_t>(*is);
+    modelInfo.index = readBytes<uint32_t>(reader);
 
-    modelInfo.memLodSpehre = readBytes<float_t>(*is);
-    modelInfo.geoLodSpehre = readBytes<float_t>(*is);
+    modelInfo.memLodSpehre = readBytes<float_t>(reader);
+    modelInfo.geoLodSpehre = readBytes<float_t>(reader);
 
-    for (size_t i = 0; i < 3; i++) {
-        modelInfo.pointFlags.push_back(readBytes<uint32_t>(*is));
-    }
+    modelInfo.pointFlags = readArray<uint32_t>(reader, 3);
 
-    modelInfo.offset1 = readXYZTriplet(*is);
-    modelInfo.mapIconColor = readBytes<uint32_t>(*is);
-    modelInfo.mapSelectedColor = readBytes<uint32_t>(*is);
+    modelInfo.offset1 = readXYZTriplet(reader);
+    modelInfo.mapIconColor = readBytes<uint32_t>(reader);
+    modelInfo.mapSelectedColor = readBytes<uint32_t>(reader);
 
-    modelInfo.viewDensity = readBytes<float_t>(*is);
+    modelInfo.viewDensity = readBytes<float_t>(reader);
 
-    modelInfo.bboxMinPosition = readXYZTriplet(*is);
-    modelInfo.bboxMaxPosition = readXYZTriplet(*is);
+    modelInfo.bboxMinPosition = readXYZTriplet(reader);
+    modelInfo.bboxMaxPosition = readXYZTriplet(reader);
 
     if (version >= 70) {
-        modelInfo.lodDensityCoef = readBytes<float_t>(*is);
+        modelInfo.lodDensityCoef = readBytes<float_t>(reader);
     }
 
     if (version >= 71) {
-        modelInfo.drawImportance = readBytes<float_t>(*is);
+        modelInfo.drawImportance = readBytes<float_t>(reader);
     }
 
     if (version >= 52) {
-        modelInfo.bboxMinVisual = readXYZTriplet(*is);
-        modelInfo.bboxMaxVisual = readXYZTriplet(*is);
+        modelInfo.bboxMinVisual = readXYZTriplet(reader);
+        modelInfo.bboxMaxVisual = readXYZTriplet(reader);
     }
 
-    modelInfo.centreOfGravity = readXYZTriplet(*is);
-    modelInfo.geometryCenter = readXYZTriplet(*is);
-    modelInfo.centerOfMass = readXYZTriplet(*is);
+    modelInfo.centreOfGravity = readXYZTriplet(reader);
+    modelInfo.geometryCenter = readXYZTriplet(reader);
+    modelInfo.centerOfMass = readXYZTriplet(reader);
 
-    for (size_t i = 0; i < 3; i++) {
-        modelInfo.modelMassVectors.push_back(readXYZTriplet(*is));
-    }
+    modelInfo.modelMassVectors = readArray<XYZTriplet>(reader, 3);
     /*
     std::vector<uint8_t> thermalProfile;
     for (size_t i = 0; i < 24; i++) {
-        thermalProfile.push_back(readBytes<uint8_t>(*is));
+        thermalProfile.push_back(readBytes<uint8_t>(reader));
     }
     */
 
-    modelInfo.autoCenter = readBytes<bool>(*is);
-    modelInfo.lockAutoCenter = readBytes<bool>(*is);
-    modelInfo.canOcclude = readBytes<bool>(*is);
-    modelInfo.canBeOccluded = readBytes<bool>(*is);
+    modelInfo.autoCenter = readBytes<bool>(reader);
+    modelInfo.lockAutoCenter = readBytes<bool>(reader);
+    modelInfo.canOcclude = readBytes<bool>(reader);
+    modelInfo.canBeOccluded = readBytes<bool>(reader);
 
     if (version >= 73) {
-        modelInfo.aiCovers = readBytes<bool>(*is);
+        modelInfo.aiCovers = readBytes<bool>(reader);
     }
 
     if (version >= 42) {
-        modelInfo.htMin = readBytes<float_t>(*is);
-        modelInfo.htMax = readBytes<float_t>(*is);
-        modelInfo.afMax = readBytes<float_t>(*is);
-        modelInfo.mfMax = readBytes<float_t>(*is);
+        modelInfo.htMin = readBytes<float_t>(reader);
+        modelInfo.htMax = readBytes<float_t>(reader);
+        modelInfo.afMax = readBytes<float_t>(reader);
+        modelInfo.mfMax = readBytes<float_t>(reader);
     }
 
     if (version >= 43) {
-        modelInfo.mFact = readBytes<float_t>(*is);
-        modelInfo.tBody = readBytes<float_t>(*is);
+        modelInfo.mFact = readBytes<float_t>(reader);
+        modelInfo.tBody = readBytes<float_t>(reader);
     }
 
     if (version >= 33) {
-        modelInfo.forceNotAlphaModel = readBytes<bool>(*is);
+        modelInfo.forceNotAlphaModel = readBytes<bool>(reader);
     }
 
     if (version >= 37) {
-        modelInfo.sbSource = readBytes<uint32_t>(*is);
-        modelInfo.preferShadowVolume = readBytes<bool>(*is);
+        modelInfo.sbSource = readBytes<uint32_t>(reader);
+        modelInfo.preferShadowVolume = readBytes<bool>(reader);
     }
 
     if (version >= 48) {
-        modelInfo.shadowOffset = readBytes<float_t>(*is);
+        modelInfo.shadowOffset = readBytes<float_t>(reader);
     }
 
-    modelInfo.animated = readBytes<bool>(*is);
+    modelInfo.animated = readBytes<bool>(reader);
     readSkeleton();
 
-    modelInfo.mapType = readBytes<uint8_t>(*is);
+    modelInfo.mapType = readBytes<uint8_t>(reader);
 
-    modelInfo.nFloats = readBytes<uint32_t>(*is);
-    modelInfo.unknownFloats = readCompressedArray<float_t>(*is, 4, useCompression, modelInfo.nFloats); // mass array?
+    modelInfo.nFloats = readBytes<uint32_t>(reader);
+    modelInfo.unknownFloats = readCompressedArray<float_t>(reader, 4, useCompression, modelInfo.nFloats); // mass array?
 
-    modelInfo.mass = readBytes<float_t>(*is);
-    modelInfo.invMass = readBytes<float_t>(*is);
-    modelInfo.armor = readBytes<float_t>(*is);
-    modelInfo.invArmor = readBytes<float_t>(*is);
+    modelInfo.mass = readBytes<float_t>(reader);
+    modelInfo.invMass = readBytes<float_t>(reader);
+    modelInfo.armor = readBytes<float_t>(reader);
+    modelInfo.invArmor = readBytes<float_t>(reader);
 
     if (version >= 72) {
-        modelInfo.explosionShielding = readBytes<float_t>(*is);
+        modelInfo.explosionShielding = readBytes<float_t>(reader);
     }
 
     if (version >= 53) {
-        modelInfo.geometrySimple = readBytes<uint8_t>(*is);
+        modelInfo.geometrySimple = readBytes<uint8_t>(reader);
     }
 
     if (version >= 54) {
-        modelInfo.geometryPhys = readBytes<uint8_t>(*is);
+        modelInfo.geometryPhys = readBytes<uint8_t>(reader);
     }
 
-    modelInfo.memory = readBytes<uint8_t>(*is);
-    modelInfo.geometry = readBytes<uint8_t>(*is);
+    modelInfo.memory = readBytes<uint8_t>(reader);
+    modelInfo.geometry = readBytes<uint8_t>(reader);
 
-    modelInfo.geometryFire = readBytes<uint8_t>(*is);
-    modelInfo.geometryView = readBytes<uint8_t>(*is);
-    modelInfo.geometryViewPilot = readBytes<uint8_t>(*is);
-    modelInfo.geometryViewGunner = readBytes<uint8_t>(*is);
+    modelInfo.geometryFire = readBytes<uint8_t>(reader);
+    modelInfo.geometryView = readBytes<uint8_t>(reader);
+    modelInfo.geometryViewPilot = readBytes<uint8_t>(reader);
+    modelInfo.geometryViewGunner = readBytes<uint8_t>(reader);
 
     // some geo View?
-    modelInfo.signedByte = readBytes<int8_t>(*is);
+    modelInfo.signedByte = readBytes<int8_t>(reader);
 
-    modelInfo.geometryViewCargo = readBytes<uint8_t>(*is);
+    modelInfo.geometryViewCargo = readBytes<uint8_t>(reader);
 
-    modelInfo.landContact = readBytes<uint8_t>(*is);
-    modelInfo.roadway = readBytes<uint8_t>(*is);
-    modelInfo.paths = readBytes<uint8_t>(*is);
-    modelInfo.hitPoints = readBytes<uint8_t>(*is);
+    modelInfo.landContact = readBytes<uint8_t>(reader);
+    modelInfo.roadway = readBytes<uint8_t>(reader);
+    modelInfo.paths = readBytes<uint8_t>(reader);
+    modelInfo.hitPoints = readBytes<uint8_t>(reader);
 
-    modelInfo.minShadow = readBytes<uint32_t>(*is);
+    modelInfo.minShadow = readBytes<uint32_t>(reader);
 
     if (version >= 38) {
-        modelInfo.canBlend = readBytes<bool>(*is);
+        modelInfo.canBlend = readBytes<bool>(reader);
     }
 
-    modelInfo.propertyClass = readZeroTerminatedString(*is);
-    modelInfo.propertyDamage = readZeroTerminatedString(*is);
-    modelInfo.propertyFrequent = readBytes<bool>(*is);
+    modelInfo.propertyClass = readZeroTerminatedString(reader);
+    modelInfo.propertyDamage = readZeroTerminatedString(reader);
+    modelInfo.propertyFrequent = readBytes<bool>(reader);
 
-    //bool allowAnimation = readBytes<bool>(*is);
+    //bool allowAnimation = readBytes<bool>(reader);
     /*
     std::vector<uint8_t> unkArmaFlags;
     for (size_t i = 0; i < 24; i++) {
-        unkArmaFlags.push_back(readBytes<uint8_t>(*is));
+        unkArmaFlags.push_back(readBytes<uint8_t>(reader));
     }
     */
     if (version >= 31) {
-        modelInfo.unknownInt = readBytes<uint32_t>(*is);
+        modelInfo.unknownInt = readBytes<uint32_t>(reader);
     }
 
     if (version >= 57) {
-        for (auto i = 0; i < modelInfo.nLods; i++) {
-            modelInfo.preferredShadowVolumeLod.push_back(readBytes<int32_t>(*is));
-        }
-
-        for (auto i = 0; i < modelInfo.nLods; i++) {
-            modelInfo.preferredShadowBufferLod.push_back(readBytes<int32_t>(*is));
-        }
-
-        for (auto i = 0; i < modelInfo.nLods; i++) {
-            modelInfo.preferredShadowBufferLodVis.push_back(readBytes<int32_t>(*is));
-        }
+        modelInfo.preferredShadowVolumeLod = readArray<int32_t>(reader, modelInfo.nLods);
+        modelInfo.preferredShadowBufferLod = readArray<int32_t>(reader, modelInfo.nLods);
+        modelInfo.preferredShadowBufferLodVis = readArray<int32_t>(reader, modelInfo.nLods);
 
     }
 
 }
 
 void grad_aff::Odol::readSkeleton() {
-    modelInfo.skeleton.name = readZeroTerminatedString(*is);
+    modelInfo.skeleton.name = readZeroTerminatedString(reader);
     if (modelInfo.skeleton.name == "")
         return;
 
     if (version >= 23)
     {
-        modelInfo.skeleton.isDiscrete = readBytes<bool>(*is);
+        modelInfo.skeleton.isDiscrete = readBytes<bool>(reader);
     }
 
-    modelInfo.skeleton.nBones = readBytes<uint32_t>(*is);
+    modelInfo.skeleton.nBones = readBytes<uint32_t>(reader);
     for (auto i = 0; i < modelInfo.skeleton.nBones; i++) {
-        modelInfo.skeleton.bones.push_back(readZeroTerminatedString(*is));
-        modelInfo.skeleton.bones.push_back(readZeroTerminatedString(*is));
+        modelInfo.skeleton.bones.push_back(readZeroTerminatedString(reader));
+        modelInfo.skeleton.bones.push_back(readZeroTerminatedString(reader));
     }
 
     if (version > 40) {
-        modelInfo.skeleton.pivotsNameObsolete = readZeroTerminatedString(*is);
+        modelInfo.skeleton.pivotsNameObsolete = readZeroTerminatedString(reader);
     }
 }
 
 void grad_aff::Odol::readAnimations() {
-    auto animsExist = readBytes<bool>(*is);
+    auto animsExist = readBytes<bool>(reader);
     if (!animsExist)
         return;
 
-    auto nAnimationClasses = readBytes<uint32_t>(*is);
+    auto nAnimationClasses = readBytes<uint32_t>(reader);
     std::vector<AnimationClass> animationClasses = {};
     for (auto i = 0; i < nAnimationClasses; i++) {
         AnimationClass animationClass;
-        animationClass.animTransformType = readBytes<uint32_t>(*is);
-        animationClass.animClassName = readZeroTerminatedString(*is);
-        animationClass.animSource = readZeroTerminatedString(*is);
+        animationClass.animTransformType = readBytes<uint32_t>(reader);
+        animationClass.animClassName = readZeroTerminatedString(reader);
+        animationClass.animSource = readZeroTerminatedString(reader);
 
-        animationClass.minValue = readBytes<float_t>(*is);
-        animationClass.maxValue = readBytes<float_t>(*is);
-        animationClass.minPhase = readBytes<float_t>(*is);
-        animationClass.maxPhase = readBytes<float_t>(*is);
+        animationClass.minValue = readBytes<float_t>(reader);
+        animationClass.maxValue = readBytes<float_t>(reader);
+        animationClass.minPhase = readBytes<float_t>(reader);
+        animationClass.maxPhase = readBytes<float_t>(reader);
 
-        animationClass.sourceAddress = readBytes<uint32_t>(*is);
+        animationClass.sourceAddress = readBytes<uint32_t>(reader);
 
         if (version >= 56) {
-            animationClass.animPeriod = readBytes<uint32_t>(*is);
-            animationClass.initPhase = readBytes<uint32_t>(*is);
+            animationClass.animPeriod = readBytes<uint32_t>(reader);
+            animationClass.initPhase = readBytes<uint32_t>(reader);
         }
 
         switch ((AnimTransformTypeEnum)animationClass.animTransformType)
@@ -349,8 +332,8 @@ void grad_aff::Odol::readAnimations() {
         {
             auto animTransformRotation = std::make_shared<AnimTransformRotation>();
             animTransformRotation->type = (AnimTransformTypeEnum)animationClass.animTransformType;
-            animTransformRotation->angle0 = readBytes<float_t>(*is);
-            animTransformRotation->angle1 = readBytes<float_t>(*is);
+            animTransformRotation->angle0 = readBytes<float_t>(reader);
+            animTransformRotation->angle1 = readBytes<float_t>(reader);
             animationClass.animType = animTransformRotation;
         }
             break;
@@ -361,8 +344,8 @@ void grad_aff::Odol::readAnimations() {
         {
             auto animTransformTranslation = std::make_shared<AnimTransformTranslation>();
             animTransformTranslation->type = (AnimTransformTypeEnum)animationClass.animTransformType;
-            animTransformTranslation->offset0 = readBytes<float_t>(*is);
-            animTransformTranslation->offset1 = readBytes<float_t>(*is);
+            animTransformTranslation->offset0 = readBytes<float_t>(reader);
+            animTransformTranslation->offset1 = readBytes<float_t>(reader);
             animationClass.animType = animTransformTranslation;
         }
             break;
@@ -370,10 +353,10 @@ void grad_aff::Odol::readAnimations() {
         {
             auto animTransformDirect = std::make_shared<AnimTransformDirect>();
             animTransformDirect->type = AnimTransformTypeEnum::DIRECT;
-            animTransformDirect->axisPos = readXYZTriplet(*is);
-            animTransformDirect->axisDir = readXYZTriplet(*is);
-            animTransformDirect->angle = readBytes<float_t>(*is);
-            animTransformDirect->axisOffset = readBytes<float_t>(*is);
+            animTransformDirect->axisPos = readXYZTriplet(reader);
+            animTransformDirect->axisDir = readXYZTriplet(reader);
+            animTransformDirect->angle = readBytes<float_t>(reader);
+            animTransformDirect->axisOffset = readBytes<float_t>(reader);
             animationClass.animType = animTransformDirect;
         }
             break;
@@ -381,9 +364,9 @@ void grad_aff::Odol::readAnimations() {
         {
             auto animTransformHide = std::make_shared<AnimTransformHide>();
             animTransformHide->type = AnimTransformTypeEnum::HIDE;
-            animTransformHide->hideValue = readBytes<float_t>(*is);
+            animTransformHide->hideValue = readBytes<float_t>(reader);
             if (version >= 55) {
-                animTransformHide->unknownFloat = readBytes<float_t>(*is);
+                animTransformHide->unknownFloat = readBytes<float_t>(reader);
             }
             animationClass.animType = animTransformHide;
         }
@@ -396,19 +379,19 @@ void grad_aff::Odol::readAnimations() {
         animationClasses.push_back(animationClass);
     }
 
-    auto nResolutions = readBytes<uint32_t>(*is);
+    auto nResolutions = readBytes<uint32_t>(reader);
 
     std::vector<Bones2Anims> bones2AnimsList = {};
     for (auto i = 0; i < nResolutions; i++) {
         Bones2Anims bones2Anims;
-        bones2Anims.nBones = readBytes<uint32_t>(*is);
+        bones2Anims.nBones = readBytes<uint32_t>(reader);
 
         for (auto j = 0; j < bones2Anims.nBones; j++) {
             Bone2AnimClassList bone2AnimClassList;
-            bone2AnimClassList.nAnimClasses = readBytes<uint32_t>(*is);
+            bone2AnimClassList.nAnimClasses = readBytes<uint32_t>(reader);
 
             for (auto k = 0; k < bone2AnimClassList.nAnimClasses; k++) {
-                bone2AnimClassList.animationClassIndex.push_back(readBytes<uint32_t>(*is));
+                bone2AnimClassList.animationClassIndex.push_back(readBytes<uint32_t>(reader));
             }
             bones2Anims.bone2AnimClassLists.push_back(bone2AnimClassList);;
         }
@@ -420,12 +403,12 @@ void grad_aff::Odol::readAnimations() {
         Anims2Bones anim2Bones;
         for (auto j = 0; j < nAnimationClasses; j++) {
             AnimBones animBones;
-            animBones.skeletonBoneNameIndex = readBytes<int32_t>(*is);
+            animBones.skeletonBoneNameIndex = readBytes<int32_t>(reader);
 
             if (animBones.skeletonBoneNameIndex != -1 &&
                 animationClasses[j].animType->type != AnimTransformTypeEnum::DIRECT && animationClasses[j].animType->type != AnimTransformTypeEnum::HIDE) {
-                animBones.axisPos = readXYZTriplet(*is);
-                animBones.axisDir = readXYZTriplet(*is);
+                animBones.axisPos = readXYZTriplet(reader);
+                animBones.axisDir = readXYZTriplet(reader);
             }
             anim2Bones.animBones.push_back(animBones);
         }
@@ -435,44 +418,39 @@ void grad_aff::Odol::readAnimations() {
 
 ODOLv4xLod grad_aff::Odol::readLod() {
     ODOLv4xLod lod;
-    lod.nProxies = readBytes<uint32_t>(*is);
+    lod.nProxies = readBytes<uint32_t>(reader);
     lod.lodProxies.reserve(lod.nProxies);
 
     for (auto i = 0; i < lod.nProxies; i++) {
         LodProxy lodProxy;
-        lodProxy.p3dProxyName = readZeroTerminatedString(*is);
-        lodProxy.transform = readMatrix(*is);
-        lodProxy.proxySeqenceID = readBytes<int32_t>(*is);
-        lodProxy.namedSelectionIndex = readBytes<int32_t>(*is);
-        lodProxy.boneIndex = readBytes<int32_t>(*is);
+        lodProxy.p3dProxyName = readZeroTerminatedString(reader);
+        lodProxy.transform = readMatrix(reader);
+        lodProxy.proxySeqenceID = readBytes<int32_t>(reader);
+        lodProxy.namedSelectionIndex = readBytes<int32_t>(reader);
+        lodProxy.boneIndex = readBytes<int32_t>(reader);
         if (this->version >= 40) {
-            lodProxy.sectionIndex = readBytes<int32_t>(*is);
+            lodProxy.sectionIndex = readBytes<int32_t>(reader);
         }
         lod.lodProxies.push_back(lodProxy);
     }
 
-    lod.nLodItems = readBytes<uint32_t>(*is);
-    lod.lodItems.reserve(lod.nLodItems);
-    for (auto i = 0; i < lod.nLodItems; i++) {
-        lod.lodItems.push_back(readBytes<uint32_t>(*is));
-    }
+    lod.nLodItems = readBytes<uint32_t>(reader);
+    lod.lodItems = readArray<uint32_t>(reader, lod.nLodItems);
 
-    lod.nBonesLinks = readBytes<uint32_t>(*is);
+    lod.nBonesLinks = readBytes<uint32_t>(reader);
     lod.lodBoneLinks.reserve(lod.nBonesLinks);
     for (auto i = 0; i < lod.nBonesLinks; i++) {
         LodBoneLink lodBoneLink;
-        lodBoneLink.nLinks = readBytes<uint32_t>(*is);
-        for (auto j = 0; j < lodBoneLink.nLinks; j++) {
-            lodBoneLink.link.push_back(readBytes<uint32_t>(*is));
-        }
+        lodBoneLink.nLinks = readBytes<uint32_t>(reader);
+        lodBoneLink.link = readArray<uint32_t>(reader, lodBoneLink.nLinks);
         lod.lodBoneLinks.push_back(lodBoneLink);
     }
 
     if (version >= 50) {
-        lod.vertexCount = readBytes<uint32_t>(*is);
+        lod.vertexCount = readBytes<uint32_t>(reader);
     }
     else {
-        auto compressedArray = readCompressedFillArray<uint32_t>(*is, useCompression);
+        auto compressedArray = readCompressedFillArray<uint32_t>(reader, useCompression);
 
         lod.lodPointFlags.clear();
         lod.lodPointFlags.reserve(compressedArray.size());
@@ -482,64 +460,64 @@ ODOLv4xLod grad_aff::Odol::readLod() {
     }
 
     if (version >= 51) {
-        lod.faceArea = readBytes<float_t>(*is);
+        lod.faceArea = readBytes<float_t>(reader);
     }
 
-    lod.orHints = static_cast<ClipFlag>(readBytes<uint32_t>(*is));
-    lod.andHints = static_cast<ClipFlag>(readBytes<uint32_t>(*is));
+    lod.orHints = static_cast<ClipFlag>(readBytes<uint32_t>(reader));
+    lod.andHints = static_cast<ClipFlag>(readBytes<uint32_t>(reader));
 
-    lod.bMin = readXYZTriplet(*is);
-    lod.bMax = readXYZTriplet(*is);
-    lod.bCeneter = readXYZTriplet(*is);
-    lod.bRadius = readBytes<float_t>(*is);
+    lod.bMin = readXYZTriplet(reader);
+    lod.bMax = readXYZTriplet(reader);
+    lod.bCeneter = readXYZTriplet(reader);
+    lod.bRadius = readBytes<float_t>(reader);
 
-    lod.nTextures = readBytes<uint32_t>(*is);
+    lod.nTextures = readBytes<uint32_t>(reader);
     lod.textures.reserve(lod.nTextures);
     for (auto i = 0; i < lod.nTextures; i++) {
-        lod.textures.push_back(readZeroTerminatedString(*is));
+        lod.textures.push_back(readZeroTerminatedString(reader));
     }
 
-    lod.nMaterials = readBytes<uint32_t>(*is);
+    lod.nMaterials = readBytes<uint32_t>(reader);
     lod.lodMaterials.reserve(lod.nMaterials);
     for (auto i = 0; i < lod.nMaterials; i++) {
         LodMaterial lodMaterial;
-        lodMaterial.rvMatName = readZeroTerminatedString(*is);
-        lodMaterial.type = readBytes<uint32_t>(*is);
+        lodMaterial.rvMatName = readZeroTerminatedString(reader);
+        lodMaterial.type = readBytes<uint32_t>(reader);
 
-        lodMaterial.emissive = readD3ColorValue(*is);
-        lodMaterial.ambient = readD3ColorValue(*is);
-        lodMaterial.diffuse = readD3ColorValue(*is);
-        lodMaterial.forcedDiffuse = readD3ColorValue(*is);
-        lodMaterial.specular = readD3ColorValue(*is);
-        lodMaterial.specular2 = readD3ColorValue(*is);
+        lodMaterial.emissive = readD3ColorValue(reader);
+        lodMaterial.ambient = readD3ColorValue(reader);
+        lodMaterial.diffuse = readD3ColorValue(reader);
+        lodMaterial.forcedDiffuse = readD3ColorValue(reader);
+        lodMaterial.specular = readD3ColorValue(reader);
+        lodMaterial.specular2 = readD3ColorValue(reader);
 
-        lodMaterial.specularPower = readBytes<float_t>(*is);
+        lodMaterial.specularPower = readBytes<float_t>(reader);
 
-        lodMaterial.pixelShader = (PixelShaderID)readBytes<uint32_t>(*is);
-        lodMaterial.vertexShader = (VertexShaderID)readBytes<uint32_t>(*is);
-        lodMaterial.mainLight = (EMainLight)readBytes<uint32_t>(*is);
-        lodMaterial.fogMode = (EFogMode)readBytes<uint32_t>(*is);
+        lodMaterial.pixelShader = (PixelShaderID)readBytes<uint32_t>(reader);
+        lodMaterial.vertexShader = (VertexShaderID)readBytes<uint32_t>(reader);
+        lodMaterial.mainLight = (EMainLight)readBytes<uint32_t>(reader);
+        lodMaterial.fogMode = (EFogMode)readBytes<uint32_t>(reader);
 
         if (lodMaterial.type == 3) {
-            lodMaterial.unkBool = readBytes<bool>(*is);
+            lodMaterial.unkBool = readBytes<bool>(reader);
         }
 
         if (lodMaterial.type >= 6) {
-            lodMaterial.surfaceFile = readZeroTerminatedString(*is);
+            lodMaterial.surfaceFile = readZeroTerminatedString(reader);
         }
 
         if (lodMaterial.type >= 4) {
-            lodMaterial.nRenderFlags = readBytes<uint32_t>(*is);
-            lodMaterial.renderFlags = readBytes<uint32_t>(*is);
+            lodMaterial.nRenderFlags = readBytes<uint32_t>(reader);
+            lodMaterial.renderFlags = readBytes<uint32_t>(reader);
         }
 
         if (lodMaterial.type > 6) {
-            lodMaterial.nStages = readBytes<uint32_t>(*is);
+            lodMaterial.nStages = readBytes<uint32_t>(reader);
         }
         if (lodMaterial.type > 8) {
-            lodMaterial.nTexGens = readBytes<uint32_t>(*is);
+            lodMaterial.nTexGens = readBytes<uint32_t>(reader);
         }
-        auto posD3 = (size_t)is->tellg();
+        auto posD3 = reader.tell();
         if (lodMaterial.type < 8) {
             throw std::runtime_error("TODO implement");
         }
@@ -547,200 +525,199 @@ ODOLv4xLod grad_aff::Odol::readLod() {
             for (auto j = 0; j < lodMaterial.nStages; j++) {
                 LodStageTexture stageTexture;
                 if (lodMaterial.type >= 5) {
-                    stageTexture.textureFilter = (TextureFilterType)readBytes<uint32_t>(*is);
+                    stageTexture.textureFilter = (TextureFilterType)readBytes<uint32_t>(reader);
                 }
-                stageTexture.paaTexture = readZeroTerminatedString(*is);
+                stageTexture.paaTexture = readZeroTerminatedString(reader);
                 if (lodMaterial.type >= 8) {
-                    stageTexture.transFormIndex = readBytes<uint32_t>(*is);
+                    stageTexture.transFormIndex = readBytes<uint32_t>(reader);
                 }
                 if (lodMaterial.type >= 11) {
-                    stageTexture.useWorldEnvMap = readBytes<bool>(*is);
+                    stageTexture.useWorldEnvMap = readBytes<bool>(reader);
                 }
                 lodMaterial.stageTexures.push_back(stageTexture);
             }
 
             for (auto j = 0; j < lodMaterial.nTexGens; j++) {
                 LodStageTransform stageTransform;
-                stageTransform.uvSource = (UVSource)readBytes<uint32_t>(*is);
-                stageTransform.transFormMatrix = readMatrix(*is);
+                stageTransform.uvSource = (UVSource)readBytes<uint32_t>(reader);
+                stageTransform.transFormMatrix = readMatrix(reader);
                 lodMaterial.stageTransforms.push_back(stageTransform);
             }
         }
         if (lodMaterial.type >= 10) {
             LodStageTexture dummyStageTexture;
             if (lodMaterial.type >= 5) {
-                dummyStageTexture.textureFilter = (TextureFilterType)readBytes<uint32_t>(*is);
+                dummyStageTexture.textureFilter = (TextureFilterType)readBytes<uint32_t>(reader);
             }
-            dummyStageTexture.paaTexture = readZeroTerminatedString(*is);
+            dummyStageTexture.paaTexture = readZeroTerminatedString(reader);
             if (lodMaterial.type >= 8) {
-                dummyStageTexture.transFormIndex = readBytes<uint32_t>(*is);
+                dummyStageTexture.transFormIndex = readBytes<uint32_t>(reader);
             }
             if (lodMaterial.type >= 11) {
-                dummyStageTexture.useWorldEnvMap = readBytes<bool>(*is);
+                dummyStageTexture.useWorldEnvMap = readBytes<bool>(reader);
             }
             lodMaterial.dummyStageTexture.push_back(dummyStageTexture);
         }
         lod.lodMaterials.push_back(lodMaterial);
     }
 
-    auto pointToVertex = readCompressedArray<uint32_t>(*is, (version >= 69 ? 4 : 2), false);
-    auto vertexToPoint = readCompressedArray<uint32_t>(*is, (version >= 69 ? 4 : 2), false);
+    auto pointToVertex = readCompressedArray<uint32_t>(reader, (version >= 69 ? 4 : 2), false);
+    auto vertexToPoint = readCompressedArray<uint32_t>(reader, (version >= 69 ? 4 : 2), false);
 
     /*
     LodEdges lodEdges;
 
     LodEdge lodEdge1;
-    lodEdge1.nEdges = readBytes<uint32_t>(*is);
+    lodEdge1.nEdges = readBytes<uint32_t>(reader);
     for (auto i = 0; i < lodEdge1.nEdges; i++) {
-        lodEdge1.edges.push_back(readBytes<uint16_t>(*is));
+        lodEdge1.edges.push_back(readBytes<uint16_t>(reader));
     }
     lodEdges.lodEdge1 = lodEdge1;
 
     LodEdge lodEdge2;
-    lodEdge2.nEdges = readBytes<uint32_t>(*is);
+    lodEdge2.nEdges = readBytes<uint32_t>(reader);
     for (auto i = 0; i < lodEdge2.nEdges; i++) {
-        lodEdge2.edges.push_back(readBytes<uint16_t>(*is));
+        lodEdge2.edges.push_back(readBytes<uint16_t>(reader));
     }
     lodEdges.lodEdge2 = lodEdge2;
 
     lod.lodEdges = lodEdges;
     */
 
-    lod.nFaces = readBytes<uint32_t>(*is);
-    lod.offsetToSectionsStruct = readBytes<uint32_t>(*is);
-    lod.alwaysZero = readBytes<uint16_t>(*is);
+    lod.nFaces = readBytes<uint32_t>(reader);
+    lod.offsetToSectionsStruct = readBytes<uint32_t>(reader);
+    lod.alwaysZero = readBytes<uint16_t>(reader);
 
+    lod.lodFaces.reserve(lod.nFaces);
     for (auto i = 0; i < lod.nFaces; i++) {
         LodFace lodFace;
-        lodFace.faceType = readBytes<uint8_t>(*is);
-        for (auto j = 0; j < lodFace.faceType; j++) {
-            if (version >= 69) {
-                lodFace.vertexTableIndex.push_back(readBytes<uint32_t>(*is));
-            }
-            else {
-                lodFace.vertexTableIndex.push_back(readBytes<uint16_t>(*is));
+        lodFace.faceType = readBytes<uint8_t>(reader);
+        if (version >= 69) {
+            lodFace.vertexTableIndex.resize(lodFace.faceType);
+            for (auto j = 0; j < lodFace.faceType; j++) {
+                lodFace.vertexTableIndex[j] = (uint16_t)readBytes<uint32_t>(reader);
             }
-
         }
-        lod.lodFaces.push_back(lodFace);
+        else {
+            lodFace.vertexTableIndex = readArray<uint16_t>(reader, lodFace.faceType);
+        }
+        lod.lodFaces.push_back(std::move(lodFace));
     }
 
-    lod.nSections = readBytes<uint32_t>(*is);
+    lod.nSections = readBytes<uint32_t>(reader);
     for (auto i = 0; i < lod.nSections; i++) {
         LodSection lodSection;
-        lodSection.faceLowerIndex = readBytes<int32_t>(*is);
-        lodSection.faceUpperIndex = readBytes<int32_t>(*is);
-        lodSection.minBonexIndex = readBytes<int32_t>(*is);
-        lodSection.bonesCount = readBytes<int32_t>(*is);
-        lodSection.commonPointsUserValue = readBytes<uint32_t>(*is);
-        lodSection.commonTextureIndex = readBytes<int16_t>(*is);
-        lodSection.commonFaceFlags = readBytes<uint32_t>(*is);
-        lodSection.materialIndex = readBytes<int32_t>(*is);
+        lodSection.faceLowerIndex = readBytes<int32_t>(reader);
+        lodSection.faceUpperIndex = readBytes<int32_t>(reader);
+        lodSection.minBonexIndex = readBytes<int32_t>(reader);
+        lodSection.bonesCount = readBytes<int32_t>(reader);
+        lodSection.commonPointsUserValue = readBytes<uint32_t>(reader);
+        lodSection.commonTextureIndex = readBytes<int16_t>(reader);
+        lodSection.commonFaceFlags = readBytes<uint32_t>(reader);
+        lodSection.materialIndex = readBytes<int32_t>(reader);
 
         if (lodSection.materialIndex == -1) {
-            lodSection.material = readZeroTerminatedString(*is);
+            lodSection.material = readZeroTerminatedString(reader);
         }
 
         if (version >= 36) {
-            lodSection.nStages = readBytes<uint32_t>(*is);
+            lodSection.nStages = readBytes<uint32_t>(reader);
             for (auto j = 0; j < lodSection.nStages; j++) {
-                lodSection.areaOverTex.push_back(readBytes<float_t>(*is));
+                lodSection.areaOverTex.push_back(readBytes<float_t>(reader));
             }
 
-            if (version >= 67 && readBytes<uint32_t>(*is) >= 1) {
+            if (version >= 67 && readBytes<uint32_t>(reader) >= 1) {
                 for (auto j = 0; j < 12; j++) {
-                    (lodSection.floats)[j] = readBytes<float_t>(*is);
+                    (lodSection.floats)[j] = readBytes<float_t>(reader);
                 }
             }
 
         }
         else {
             lodSection.nStages = 1;
-            lodSection.areaOverTex.push_back(readBytes<float_t>(*is));
+            lodSection.areaOverTex.push_back(readBytes<float_t>(reader));
         }
         lod.lodSections.push_back(lodSection);
     }
 
-    lod.nNamedSelections = readBytes<uint32_t>(*is);
+    lod.nNamedSelections = readBytes<uint32_t>(reader);
     for (auto i = 0; i < lod.nNamedSelections; i++) {
         LodNamedSelection lodNamedSelection;
-        lodNamedSelection.selectedName = readZeroTerminatedString(*is);
+        lodNamedSelection.selectedName = readZeroTerminatedString(reader);
 
-        //lodNamedSelection.nFaces = readBytes<uint32_t>(*is);
+        //lodNamedSelection.nFaces = readBytes<uint32_t>(reader);
         // I will hate myself for this horrible hack
         if (version >= 45) {
-            lodNamedSelection.faceIndexes = readCompressedArray<uint16_t>(*is, (version >= 69 ? 4 : 2), useCompression);
+            lodNamedSelection.faceIndexes = readCompressedArray<uint16_t>(reader, (version >= 69 ? 4 : 2), useCompression);
         }
         else {
-            lodNamedSelection.faceIndexes = readCompressedArrayOld<uint16_t>(*is, (version >= 69 ? 4 : 2), useCompression);
+            lodNamedSelection.faceIndexes = readCompressedArrayOld<uint16_t>(reader, (version >= 69 ? 4 : 2), useCompression);
         }
         /*
         if (version >= 69) {
-            lodNamedSelection.faceIndexes = readLZOCompressed<uint16_t>(*is, (size_t)lodNamedSelection.nFaces * 4).first;
+            lodNamedSelection.faceIndexes = readLZOCompressed<uint16_t>(reader, (size_t)lodNamedSelection.nFaces * 4).first;
         }
         else {
-            lodNamedSelection.faceIndexes = readLZOCompressed<uint16_t>(*is, (size_t)lodNamedSelection.nFaces * 2).first;
+            lodNamedSelection.faceIndexes = readLZOCompressed<uint16_t>(reader, (size_t)lodNamedSelection.nFaces * 2).first;
         }
         */
-        lodNamedSelection.alwaysZero = readBytes<uint32_t>(*is);
-        lodNamedSelection.isSectional = readBytes<bool>(*is);
-        lodNamedSelection.sectionIndex = readCompressedArray<uint32_t>(*is, 4, useCompression);
+        lodNamedSelection.alwaysZero = readBytes<uint32_t>(reader);
+        lodNamedSelection.isSectional = readBytes<bool>(reader);
+        lodNamedSelection.sectionIndex = readCompressedArray<uint32_t>(reader, 4, useCompression);
         lodNamedSelection.nSections = lodNamedSelection.sectionIndex.size();
-        //lodNamedSelection.vertexTableIndexes = readCompressedArray<uint16_t>(*is, (version >= 69 ? 4 : 2), useCompression);
+        //lodNamedSelection.vertexTableIndexes = readCompressedArray<uint16_t>(reader, (version >= 69 ? 4 : 2), useCompression);
         if (version >= 45) {
-            lodNamedSelection.vertexTableIndexes = readCompressedArray<uint16_t>(*is, (version >= 69 ? 4 : 2), useCompression);
+            lodNamedSelection.vertexTableIndexes = readCompressedArray<uint16_t>(reader, (version >= 69 ? 4 : 2), useCompression);
         }
         else {
-            lodNamedSelection.vertexTableIndexes = readCompressedArrayOld<uint16_t>(*is, (version >= 69 ? 4 : 2), useCompression);
+            lodNamedSelection.vertexTableIndexes = readCompressedArrayOld<uint16_t>(reader, (version >= 69 ? 4 : 2), useCompression);
         }
-        /*lodNamedSelection.nVertices = readBytes<uint32_t>(*is);
+        /*lodNamedSelection.nVertices = readBytes<uint32_t>(reader);
         if (version >= 69) {
-            lodNamedSelection.vertexTableIndexes = readLZOCompressed<uint16_t>(*is, (size_t)lodNamedSelection.nVertices * 4).first;
+            lodNamedSelection.vertexTableIndexes = readLZOCompressed<uint16_t>(reader, (size_t)lodNamedSelection.nVertices * 4).first;
         }
         else {
-            lodNamedSelection.vertexTableIndexes = readLZOCompressed<uint16_t>(*is, (size_t)lodNamedSelection.nVertices * 2).first;
+            lodNamedSelection.vertexTableIndexes = readLZOCompressed<uint16_t>(reader, (size_t)lodNamedSelection.nVertices * 2).first;
         }
         */
-        lodNamedSelection.nTextureWeights = readBytes<uint32_t>(*is);
-        //lodNamedSelection.verticesWeights = readLZOCompressed<uint8_t>(*is, lodNamedSelection.nTextureWeights).first;
-        lodNamedSelection.verticesWeights = readCompressed(*is, lodNamedSelection.nTextureWeights, this->useCompression);
+        lodNamedSelection.nTextureWeights = readBytes<uint32_t>(reader);
+        //lodNamedSelection.verticesWeights = readLZOCompressed<uint8_t>(reader, lodNamedSelection.nTextureWeights).first;
+        lodNamedSelection.verticesWeights = readCompressed(reader, lodNamedSelection.nTextureWeights, this->useCompression);
 
         lod.namedSelections.push_back(lodNamedSelection);
     }
 
-    lod.nTokens = readBytes<uint32_t>(*is);
+    lod.nTokens = readBytes<uint32_t>(reader);
     for (auto i = 0; i < lod.nTokens; i++) {
-        lod.tokens.insert(std::make_pair(readZeroTerminatedString(*is), readZeroTerminatedString(*is)));
+        lod.tokens.insert(std::make_pair(readZeroTerminatedString(reader), readZeroTerminatedString(reader)));
     }
 
-    lod.nFrames = readBytes<uint32_t>(*is);
+    lod.nFrames = readBytes<uint32_t>(reader);
     for (auto i = 0; i < lod.nFrames; i++) {
         LodFrame lodFrame;
-        lodFrame.frameTime = readBytes<float_t>(*is);
-        lodFrame.nBones = readBytes<uint32_t>(*is);
-        for (auto k = 0; k < lodFrame.nBones; k++) {
-            lodFrame.bonePositions.push_back(readXYZTriplet(*is));
-        }
+        lodFrame.frameTime = readBytes<float_t>(reader);
+        lodFrame.nBones = readBytes<uint32_t>(reader);
+        lodFrame.bonePositions = readArray<XYZTriplet>(reader, lodFrame.nBones);
         lod.lodFrames.push_back(lodFrame);
     }
 
-    lod.iconColor = readBytes<uint32_t>(*is);
-    lod.selectedColor = readBytes<uint32_t>(*is);
-    lod.special = readBytes<uint32_t>(*is);
-    lod.vertexBoneRefIsImple = readBytes<bool>(*is);
-    lod.sizeOfVertexTable = readBytes<uint32_t>(*is);
+    lod.iconColor = readBytes<uint32_t>(reader);
+    lod.selectedColor = readBytes<uint32_t>(reader);
+    lod.special = readBytes<uint32_t>(reader);
+    lod.vertexBoneRefIsImple = readBytes<bool>(reader);
+    lod.sizeOfVertexTable = readBytes<uint32_t>(reader);
 
     if (version >= 50) {
-        lod.nClipFlags = readBytes<uint32_t>(*is);
-        if (readBytes<bool>(*is)) {
-            auto val = (ClipFlag)readBytes<uint32_t>(*is);
+        lod.nClipFlags = readBytes<uint32_t>(reader);
+        if (readBytes<bool>(reader)) {
+            auto val = (ClipFlag)readBytes<uint32_t>(reader);
             for (auto i = 0; i < lod.nClipFlags; i++) {
                 lod.clipFlags.push_back(val);
             }
         }
         else {
-            //auto uncompressed = readLZOCompressed<uint32_t>(*is, (size_t)lod.nClipFlags * 4).first;
-            auto uncompressed = readCompressed(*is, (size_t)lod.nClipFlags * 4, this->useCompression);
+            //auto uncompressed = readLZOCompressed<uint32_t>(reader, (size_t)lod.nClipFlags * 4).first;
+            auto uncompressed = readCompressed(reader, (size_t)lod.nClipFlags * 4, this->useCompression);
             for (auto& flag : uncompressed) {
                 lod.clipFlags.push_back((ClipFlag)flag);
             }
@@ -749,14 +726,14 @@ ODOLv4xLod grad_aff::Odol::readLod() {
 
     lod.defaultUvSet = readUVSet();
 
-    lod.nUvs = readBytes<uint32_t>(*is);
+    lod.nUvs = readBytes<uint32_t>(reader);
 
     // 0 = default uv set
     for (auto i = 1; i < lod.nUvs; i++) {
         lod.uvSets.push_back(readUVSet());
     }
 
-    lod.nPoints = readBytes<uint32_t>(*is);
+    lod.nPoints = readBytes<uint32_t>(reader);
 
     auto expectedSizeVertices = lod.nPoints * 12;
     std::vector<float_t> vertices = {};
@@ -764,38 +741,23 @@ ODOLv4xLod grad_aff::Odol::readLod() {
 
         bool lzoCompressed = expectedSizeVertices >= 1024;
         if (useCompression) {
-            lzoCompressed = readBytes<bool>(*is);
+            lzoCompressed = readBytes<bool>(reader);
         }
         if (lzoCompressed) {
-            vertices = readLZOCompressed<float_t>(*is, expectedSizeVertices).first;
+            vertices = readLZOCompressed<float_t>(reader, expectedSizeVertices).first;
         }
         else {
-            for (auto i = 0; i < expectedSizeVertices / 4; i++) {
-                vertices.push_back(readBytes<float_t>(*is));
-            }
+            vertices = readArray<float_t>(reader, expectedSizeVertices / 4);
         }
     }
     else {
-        auto vertData = readCompressedLZOLZSS(*is, expectedSizeVertices, useLzo);
-
-        union {
-            float f;
-            uint8_t b[4];
-        } b2f;
-
-        for (size_t i = 0; i < vertData.size(); i+=4)
-        {
-            b2f.b[0] = vertData[i];
-            b2f.b[1] = vertData[i+1];
-            b2f.b[2] = vertData[i+2];
-            b2f.b[3] = vertData[i+3];
-            vertices.push_back(b2f.f);
-        }
+        auto vertData = readCompressedLZOLZSS(reader, expectedSizeVertices, useLzo);
+        vertices.resize(vertData.size() / 4);
+        std::memcpy(vertices.data(), vertData.data(), vertices.size() * 4);
     }
 
-    for (auto i = 0; i < vertices.size(); i+= 3) {
-        lod.lodPoints.push_back({ vertices[i], vertices[i + 1], vertices[i + 2] });
-    }
+    lod.lodPoints.resize(vertices.size() / 3);
+    std::memcpy(lod.lodPoints.data(), vertices.data(), lod.lodPoints.size() * sizeof(XYZTriplet));
 
     return lod;
     for (auto i = 0; i < vertices.size(); i += 3) {
@@ -808,17 +770,17 @@ ODOLv4xLod grad_aff::Odol::readLod() {
 
     /*
     if (version >= 45) {
-        lod.nNormals = readBytes<uint32_t>(*is);
-        if (readBytes<bool>(*is)) {
-            auto val = readBytes<uint32_t>(*is);
+        lod.nNormals = readBytes<uint32_t>(reader);
+        if (readBytes<bool>(reader)) {
+            auto val = readBytes<uint32_t>(reader);
             auto xyz = decodeXYZ(val);
             for (auto i = 0; i < lod.nNormals; i++) {
                 lod.lodNormals.push_back(xyz);
             }
         }
         else {
-            //auto uncompressed = readLZOCompressed<uint32_t>(*is, (size_t)lod.nNormals * 4).first;
-            auto uncompressed = readCompressedArray<uint32_t>(*is, (size_t)lod.nNormals * 4, useCompression, lod.nNormals);
+            //auto uncompressed = readLZOCompressed<uint32_t>(reader, (size_t)lod.nNormals * 4).first;
+            auto uncompressed = readCompressedArray<uint32_t>(reader, (size_t)lod.nNormals * 4, useCompression, lod.nNormals);
             for (auto& compressedXYZ : uncompressed) {
                lod.lodNormals.push_back(decodeXYZ(compressedXYZ));
             }
@@ -833,19 +795,19 @@ ODOLv4xLod grad_aff::Odol::readLod() {
     // TODO after rework
 
     if (version >= 45) {
-        lod.nMinMax = readBytes<uint32_t>(*is);
+        lod.nMinMax = readBytes<uint32_t>(reader);
         auto expectedSizeMinMax = lod.nMinMax * 8;
         std::vector<float_t> minMax = {};
         bool lzoCompressed = expectedSizeMinMax >= 1024;
         if (useCompression) {
-            lzoCompressed = readBytes<bool>(*is);
+            lzoCompressed = readBytes<bool>(reader);
         }
         if (lzoCompressed) {
-            minMax = readLZOCompressed<float_t>(*is, expectedSizeMinMax).first;
+            minMax = readLZOCompressed<float_t>(reader, expectedSizeMinMax).first;
         }
         else {
             for (auto i = 0; i < expectedSizeMinMax / 4; i++) {
-                minMax.push_back(readBytes<float_t>(*is));
+                minMax.push_back(readBytes<float_t>(reader));
             }
         }
         for (auto i = 0; i < minMax.size(); i += 3) {
@@ -860,19 +822,19 @@ ODOLv4xLod grad_aff::Odol::readLod() {
         throw std::runtime_error("TODO implement");
     }
     /*
-    lod.nProperties = readBytes<uint32_t>(*is);
+    lod.nProperties = readBytes<uint32_t>(reader);
     auto expectedSizeProps = lod.nProperties * 12;
     std::vector<float_t> props = {};
     bool lzoCompressed = expectedSizeProps >= 1024;
     if (useCompression) {
-        lzoCompressed = readBytes<bool>(*is);
+        lzoCompressed = readBytes<bool>(reader);
     }
     if (lzoCompressed) {
-        props = readLZOCompressed<float_t>(*is, expectedSizeProps).first;
+        props = readLZOCompressed<float_t>(reader, expectedSizeProps).first;
     }
     else {
         for (auto i = 0; i < expectedSizeProps / 4; i++) {
-            props.push_back(readBytes<float_t>(*is));
+            props.push_back(readBytes<float_t>(reader));
         }
     }
     for (auto i = 0; i < props.size(); i += 3) {
@@ -889,29 +851,29 @@ ODOLv4xLod grad_aff::Odol::readLod() {
 UVSet grad_aff::Odol::readUVSet() {
     UVSet uvSet;
     if (version >= 45) {
-        uvSet.minU = readBytes<float_t>(*is);
-        uvSet.minV = readBytes<float_t>(*is);
-        uvSet.maxU = readBytes<float_t>(*is);
-        uvSet.maxV = readBytes<float_t>(*is);
+        uvSet.minU = readBytes<float_t>(reader);
+        uvSet.minV = readBytes<float_t>(reader);
+        uvSet.maxU = readBytes<float_t>(reader);
+        uvSet.maxV = readBytes<float_t>(reader);
     }
 
-    uvSet.nVertices = readBytes<uint32_t>(*is);
-    uvSet.defaultFill = readBytes<bool>(*is);
+    uvSet.nVertices = readBytes<uint32_t>(reader);
+    uvSet.defaultFill = readBytes<bool>(reader);
     if (uvSet.defaultFill) {
         if (version >= 45) {
-            uvSet.defaultValue = readBytes<float_t>(*is);
+            uvSet.defaultValue = readBytes<float_t>(reader);
         }
         else {
-            uvSet.defaultValue = std::make_pair<float_t, float_t>(readBytes<float_t>(*is), readBytes<float_t>(*is));
+            uvSet.defaultValue = std::make_pair<float_t, float_t>(readBytes<float_t>(reader), readBytes<float_t>(reader));
         }
         return uvSet;
     }
     else {
         if (version >= 45) {
-            uvSet.uvData = readCompressed(*is, (size_t)uvSet.nVertices * (version >= 45 ? 4 : 8), useCompression);
+            uvSet.uvData = readCompressed(reader, (size_t)uvSet.nVertices * (version >= 45 ? 4 : 8), useCompression);
         }
         else {
-            uvSet.uvData = readCompressedLZOLZSS(*is, (size_t)uvSet.nVertices * (version >= 45 ? 4 : 8), useCompression);
+            uvSet.uvData = readCompressedLZOLZSS(reader, (size_t)uvSet.nVertices * (version >= 45 ? 4 : 8), useCompression);
         }
     }
     return uvSet;
@@ -940,13 +902,13 @@ std::vector<uint8_t> grad_aff::Odol::readLZOWithRule(uint32_t expectedSize)
     bool flag = expectedSize >= 1024;
     if (useCompression)
     {
-        flag = readBytes<bool>(*is);
+        flag = readBytes<bool>(reader);
     }
     if (!flag)
     {
-        return readBytes(*is, expectedSize);
+        return readBytes(reader, expectedSize);
     }
-    return readLZOCompressed(*is, expectedSize).first;
+    return readLZOCompressed(reader, expectedSize).first;
 }
 
 LodType grad_aff::Odol::getLodType(float_t resolution) {
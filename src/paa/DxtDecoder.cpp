@@ -0,0 +1,190 @@
+#include "grad_aff/paa/DxtDecoder.h"
+
+#include "grad_aff/Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define GRAD_AFF_DXT_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace {
+    // pixels as little endian r | g << 8 | b << 16 | a << 24
+    uint32_t unpack565(uint16_t value) {
+        uint32_t r = (value >> 11) & 0x1f;
+        uint32_t g = (value >> 5) & 0x3f;
+        uint32_t b = value & 0x1f;
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        return r | g << 8 | b << 16 | 0xff000000;
+    }
+
+    uint32_t channel(uint32_t colour, int shift) {
+        return (colour >> shift) & 0xff;
+    }
+
+    // BC3 always uses four colours, BC1 switches to three and transparent black if the endpoints aren't descending
+    std::array<uint32_t, 4> colourPalette(const uint8_t* block, bool isBc1) {
+        uint16_t a, b;
+        std::memcpy(&a, block, 2);
+        std::memcpy(&b, block + 2, 2);
+        std::array<uint32_t, 4> palette = { unpack565(a), unpack565(b), 0xff000000, 0xff000000 };
+        for (int shift = 0; shift < 24; shift += 8) {
+            auto c = channel(palette[0], shift);
+            auto d = channel(palette[1], shift);
+            if (isBc1 && a <= b) {
+                palette[2] |= ((c + d) / 2) << shift;
+            }
+            else {
+                palette[2] |= ((2 * c + d) / 3) << shift;
+                palette[3] |= ((c + 2 * d) / 3) << shift;
+            }
+        }
+        if (isBc1 && a <= b) {
+            palette[3] = 0;
+        }
+        return palette;
+    }
+
+    std::array<uint8_t, 8> alphaPalette(const uint8_t* block) {
+        uint32_t a = block[0];
+        uint32_t b = block[1];
+        std::array<uint8_t, 8> palette = { (uint8_t)a, (uint8_t)b };
+        if (a <= b) {
+            for (uint32_t i = 1; i < 5; i++) {
+                palette[1 + i] = (uint8_t)(((5 - i) * a + i * b) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        else {
+            for (uint32_t i = 1; i < 7; i++) {
+                palette[1 + i] = (uint8_t)(((7 - i) * a + i * b) / 7);
+            }
+        }
+        return palette;
+    }
+
+    // 3 bit indices of the 16 pixels, low bits first
+    uint64_t alphaIndices(const uint8_t* block) {
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++) {
+            indices |= (uint64_t)block[2 + i] << (8 * i);
+        }
+        return indices;
+    }
+
+    // alpha has the alpha of every pixel in the top byte and replaces the palette alpha, BC1 passes nullptr
+    void writeColourBlock(const uint8_t* colourBlock, bool isBc1, const std::array<uint32_t, 16>* alpha, uint8_t* rgba, size_t pitch) {
+        auto palette = colourPalette(colourBlock, isBc1);
+#ifdef GRAD_AFF_DXT_SSE2
+        // no shuffle by variable index in SSE2, every lane picks its palette entry by compare and mask
+        const auto entry0 = _mm_set1_epi32((int32_t)palette[0]);
+        const auto entry1 = _mm_set1_epi32((int32_t)palette[1]);
+        const auto entry2 = _mm_set1_epi32((int32_t)palette[2]);
+        const auto entry3 = _mm_set1_epi32((int32_t)palette[3]);
+        const auto zero = _mm_setzero_si128();
+        const auto one = _mm_set1_epi32(1);
+        const auto two = _mm_set1_epi32(2);
+        const auto three = _mm_set1_epi32(3);
+        const auto colourMask = _mm_set1_epi32(0x00ffffff);
+        for (int row = 0; row < 4; row++) {
+            uint32_t bits = colourBlock[4 + row];
+            auto indices = _mm_set_epi32((int32_t)(bits >> 6), (int32_t)((bits >> 4) & 3), (int32_t)((bits >> 2) & 3), (int32_t)(bits & 3));
+            auto pixels = _mm_and_si128(_mm_cmpeq_epi32(indices, zero), entry0);
+            pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_cmpeq_epi32(indices, one), entry1));
+            pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_cmpeq_epi32(indices, two), entry2));
+            pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_cmpeq_epi32(indices, three), entry3));
+            if (alpha != nullptr) {
+                auto rowAlpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha->data() + row * 4));
+                pixels = _mm_or_si128(_mm_and_si128(pixels, colourMask), rowAlpha);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + row * pitch), pixels);
+        }
+#else
+        for (int row = 0; row < 4; row++) {
+            uint32_t bits = colourBlock[4 + row];
+            std::array<uint32_t, 4> pixels;
+            for (int x = 0; x < 4; x++) {
+                pixels[x] = palette[(bits >> (2 * x)) & 3];
+                if (alpha != nullptr) {
+                    pixels[x] = (pixels[x] & 0x00ffffff) | (*alpha)[row * 4 + x];
+                }
+            }
+            std::memcpy(rgba + row * pitch, pixels.data(), 16);
+        }
+#endif
+    }
+
+    template<bool IsBc1>
+    void decodeImage(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba) {
+        const size_t bytesPerBlock = IsBc1 ? 8 : 16;
+        const size_t blocksX = ((size_t)width + 3) / 4;
+        const size_t blocksY = ((size_t)height + 3) / 4;
+        const size_t pitch = (size_t)width * 4;
+
+        auto decodeRow = [&](size_t by) {
+            auto block = blocks + by * blocksX * bytesPerBlock;
+            for (size_t bx = 0; bx < blocksX; bx++, block += bytesPerBlock) {
+                auto x = bx * 4;
+                auto y = by * 4;
+                // border blocks go through a scratch block
+                if (x + 4 <= width && y + 4 <= height) {
+                    if (IsBc1) {
+                        grad_aff::decodeBc1Block(block, rgba + y * pitch + x * 4, pitch);
+                    }
+                    else {
+                        grad_aff::decodeBc3Block(block, rgba + y * pitch + x * 4, pitch);
+                    }
+                    continue;
+                }
+                std::array<uint8_t, 64> scratch;
+                if (IsBc1) {
+                    grad_aff::decodeBc1Block(block, scratch.data(), 16);
+                }
+                else {
+                    grad_aff::decodeBc3Block(block, scratch.data(), 16);
+                }
+                auto columns = std::min<size_t>(4, width - x);
+                for (size_t py = 0; py < 4 && y + py < height; py++) {
+                    std::memcpy(rgba + (y + py) * pitch + x * 4, scratch.data() + py * 16, columns * 4);
+                }
+            }
+        };
+
+        // small levels aren't worth the threads
+        if (blocksX * blocksY < 4096) {
+            for (size_t by = 0; by < blocksY; by++) {
+                decodeRow(by);
+            }
+            return;
+        }
+        grad_aff::parallelFor(0, blocksY, decodeRow);
+    }
+}
+
+void grad_aff::decodeBc1Block(const uint8_t* block, uint8_t* rgba, size_t pitch) {
+    writeColourBlock(block, true, nullptr, rgba, pitch);
+}
+
+void grad_aff::decodeBc3Block(const uint8_t* block, uint8_t* rgba, size_t pitch) {
+    auto palette = alphaPalette(block);
+    auto indices = alphaIndices(block);
+    std::array<uint32_t, 16> alpha;
+    for (int i = 0; i < 16; i++) {
+        alpha[i] = (uint32_t)palette[(indices >> (3 * i)) & 7] << 24;
+    }
+    writeColourBlock(block + 8, false, &alpha, rgba, pitch);
+}
+
+void grad_aff::decodeBc1(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba) {
+    decodeImage<true>(blocks, width, height, rgba);
+}
+
+void grad_aff::decodeBc3(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba) {
+    decodeImage<false>(blocks, width, height, rgba);
+}
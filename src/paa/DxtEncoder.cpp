@@ -0,0 +1,271 @@
+#include "grad_aff/paa/DxtEncoder.h"
+
+#include "grad_aff/Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define GRAD_AFF_DXT_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace {
+    using Pixels = std::array<uint32_t, 16>;
+
+    uint32_t channel(uint32_t colour, int shift) {
+        return (colour >> shift) & 0xff;
+    }
+
+    Pixels loadBlock(const uint8_t* rgba, size_t pitch) {
+        Pixels pixels;
+        for (int row = 0; row < 4; row++) {
+            std::memcpy(pixels.data() + row * 4, rgba + row * pitch, 16);
+        }
+        return pixels;
+    }
+
+    // per channel min and max of the pixels selected by mask
+    void boundingBox(const Pixels& pixels, uint32_t mask, uint32_t& minColour, uint32_t& maxColour) {
+#ifdef GRAD_AFF_DXT_SSE2
+        if (mask == 0xffff) {
+            auto row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels.data()));
+            auto row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels.data() + 4));
+            auto row2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels.data() + 8));
+            auto row3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels.data() + 12));
+            auto low = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+            auto high = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+            // fold the four pixels of a row
+            low = _mm_min_epu8(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(1, 0, 3, 2)));
+            low = _mm_min_epu8(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+            high = _mm_max_epu8(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(1, 0, 3, 2)));
+            high = _mm_max_epu8(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(2, 3, 0, 1)));
+            minColour = (uint32_t)_mm_cvtsi128_si32(low);
+            maxColour = (uint32_t)_mm_cvtsi128_si32(high);
+            return;
+        }
+#endif
+        minColour = 0xffffffff;
+        maxColour = 0;
+        for (int i = 0; i < 16; i++) {
+            if ((mask & (1 << i)) == 0) {
+                continue;
+            }
+            uint32_t low = 0, high = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                low |= std::min(channel(minColour, shift), channel(pixels[i], shift)) << shift;
+                high |= std::max(channel(maxColour, shift), channel(pixels[i], shift)) << shift;
+            }
+            minColour = low;
+            maxColour = high;
+        }
+    }
+
+    // The box has four diagonals, swap red or blue between the endpoints when they fall with green.
+    // Green is the reference as it has the most weight, red takes over for grey free blocks without green.
+    void flipDiagonal(const Pixels& pixels, uint32_t mask, uint32_t minColour, uint32_t maxColour, uint32_t& low, uint32_t& high) {
+        int32_t centre[3];
+        for (int c = 0; c < 3; c++) {
+            centre[c] = (int32_t)(channel(minColour, c * 8) + channel(maxColour, c * 8)) / 2;
+        }
+        int reference = channel(minColour, 8) != channel(maxColour, 8) ? 1 : 0;
+        for (int c = 0; c < 3; c++) {
+            if (c == reference) {
+                continue;
+            }
+            int32_t covariance = 0;
+            for (int i = 0; i < 16; i++) {
+                if (mask & (1 << i)) {
+                    covariance += ((int32_t)channel(pixels[i], c * 8) - centre[c]) * ((int32_t)channel(pixels[i], reference * 8) - centre[reference]);
+                }
+            }
+            if (covariance < 0) {
+                uint32_t channelMask = 0xffu << (c * 8);
+                auto swapped = low & channelMask;
+                low = (low & ~channelMask) | (high & channelMask);
+                high = (high & ~channelMask) | swapped;
+            }
+        }
+    }
+
+    uint16_t pack565(uint32_t colour) {
+        return (uint16_t)(((channel(colour, 0) >> 3) << 11) | ((channel(colour, 8) >> 2) << 5) | (channel(colour, 16) >> 3));
+    }
+
+    uint32_t unpack565(uint16_t value) {
+        uint32_t r = (value >> 11) & 0x1f;
+        uint32_t g = (value >> 5) & 0x3f;
+        uint32_t b = value & 0x1f;
+        return ((r << 3) | (r >> 2)) | ((g << 2) | (g >> 4)) << 8 | ((b << 3) | (b >> 2)) << 16;
+    }
+
+    uint32_t distance(uint32_t a, uint32_t b) {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            auto d = (int32_t)channel(a, shift) - (int32_t)channel(b, shift);
+            result += (uint32_t)(d * d);
+        }
+        return result;
+    }
+
+    // endpoints and indices of the colour part, threeColour leaves pixels outside mask transparent
+    void encodeColour(const Pixels& pixels, uint32_t mask, bool threeColour, uint8_t* block) {
+        if (mask == 0) {
+            // everything transparent, index 3 of the three colour mode
+            std::memset(block, 0, 4);
+            std::memset(block + 4, 0xff, 4);
+            return;
+        }
+
+        uint32_t minColour, maxColour;
+        boundingBox(pixels, mask, minColour, maxColour);
+        // move the endpoints in by 1/16 of the range, the box corners are rarely hit
+        uint32_t low = 0, high = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            auto inset = (channel(maxColour, shift) - channel(minColour, shift)) >> 4;
+            low |= (channel(minColour, shift) + inset) << shift;
+            high |= (channel(maxColour, shift) - inset) << shift;
+        }
+        flipDiagonal(pixels, mask, minColour, maxColour, low, high);
+
+        auto a = pack565(high);
+        auto b = pack565(low);
+        // four colours need a > b, three colours a <= b
+        if (threeColour ? a > b : a < b) {
+            std::swap(a, b);
+        }
+        std::array<uint32_t, 4> palette = { unpack565(a), unpack565(b), 0, 0 };
+        size_t entries = threeColour ? 3 : 4;
+        for (int shift = 0; shift < 24; shift += 8) {
+            auto c = channel(palette[0], shift);
+            auto d = channel(palette[1], shift);
+            if (threeColour) {
+                palette[2] |= ((c + d) / 2) << shift;
+            }
+            else {
+                palette[2] |= ((2 * c + d) / 3) << shift;
+                palette[3] |= ((c + 2 * d) / 3) << shift;
+            }
+        }
+        // equal endpoints in four colour mode would read as three colours in BC1
+        if (a == b) {
+            entries = 1;
+        }
+
+        uint32_t indices = 0;
+        for (int i = 0; i < 16; i++) {
+            uint32_t index = 3;
+            if (mask & (1 << i)) {
+                index = 0;
+                auto best = distance(pixels[i], palette[0]);
+                for (uint32_t e = 1; e < entries; e++) {
+                    auto d = distance(pixels[i], palette[e]);
+                    if (d < best) {
+                        best = d;
+                        index = e;
+                    }
+                }
+            }
+            indices |= index << (2 * i);
+        }
+
+        std::memcpy(block, &a, 2);
+        std::memcpy(block + 2, &b, 2);
+        std::memcpy(block + 4, &indices, 4);
+    }
+
+    void encodeAlpha(const Pixels& pixels, uint8_t* block) {
+        uint32_t low = 255, high = 0;
+        for (auto pixel : pixels) {
+            low = std::min(low, pixel >> 24);
+            high = std::max(high, pixel >> 24);
+        }
+        // high > low selects the eight alpha mode: 0 is high, 1 low, 2 to 7 in between
+        block[0] = (uint8_t)high;
+        block[1] = (uint8_t)low;
+        uint64_t indices = 0;
+        if (high != low) {
+            auto range = high - low;
+            for (int i = 0; i < 16; i++) {
+                auto step = ((high - (pixels[i] >> 24)) * 7 + range / 2) / range;
+                uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+                indices |= index << (3 * i);
+            }
+        }
+        for (int i = 0; i < 6; i++) {
+            block[2 + i] = (uint8_t)(indices >> (8 * i));
+        }
+    }
+
+    template<bool IsBc1>
+    void encodeImage(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks) {
+        const size_t bytesPerBlock = IsBc1 ? 8 : 16;
+        const size_t blocksX = ((size_t)width + 3) / 4;
+        const size_t blocksY = ((size_t)height + 3) / 4;
+        const size_t pitch = (size_t)width * 4;
+
+        auto encodeRow = [&](size_t by) {
+            auto block = blocks + by * blocksX * bytesPerBlock;
+            for (size_t bx = 0; bx < blocksX; bx++, block += bytesPerBlock) {
+                auto x = bx * 4;
+                auto y = by * 4;
+                auto source = rgba + y * pitch + x * 4;
+                auto sourcePitch = pitch;
+                // border blocks are padded with the last row and column
+                std::array<uint8_t, 64> scratch;
+                if (x + 4 > width || y + 4 > height) {
+                    for (size_t py = 0; py < 4; py++) {
+                        for (size_t px = 0; px < 4; px++) {
+                            auto sx = std::min<size_t>(x + px, width - 1);
+                            auto sy = std::min<size_t>(y + py, height - 1);
+                            std::memcpy(scratch.data() + py * 16 + px * 4, rgba + sy * pitch + sx * 4, 4);
+                        }
+                    }
+                    source = scratch.data();
+                    sourcePitch = 16;
+                }
+                if (IsBc1) {
+                    grad_aff::encodeBc1Block(source, sourcePitch, block);
+                }
+                else {
+                    grad_aff::encodeBc3Block(source, sourcePitch, block);
+                }
+            }
+        };
+
+        // small levels aren't worth the threads
+        if (blocksX * blocksY < 1024) {
+            for (size_t by = 0; by < blocksY; by++) {
+                encodeRow(by);
+            }
+            return;
+        }
+        grad_aff::parallelFor(0, blocksY, encodeRow);
+    }
+}
+
+void grad_aff::encodeBc1Block(const uint8_t* rgba, size_t pitch, uint8_t* block) {
+    auto pixels = loadBlock(rgba, pitch);
+    uint32_t opaque = 0;
+    for (int i = 0; i < 16; i++) {
+        if ((pixels[i] >> 24) >= 128) {
+            opaque |= 1 << i;
+        }
+    }
+    encodeColour(pixels, opaque, opaque != 0xffff, block);
+}
+
+void grad_aff::encodeBc3Block(const uint8_t* rgba, size_t pitch, uint8_t* block) {
+    auto pixels = loadBlock(rgba, pitch);
+    encodeAlpha(pixels, block);
+    encodeColour(pixels, 0xffff, false, block + 8);
+}
+
+void grad_aff::encodeBc1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks) {
+    encodeImage<true>(rgba, width, height, blocks);
+}
+
+void grad_aff::encodeBc3(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks) {
+    encodeImage<false>(rgba, width, height, blocks);
+}
@@ -4,6 +4,12 @@
 #include <lzokay.hpp>
 
 #include "grad_aff/paa/squishMod.h"
+#include "grad_aff/paa/DxtDecoder.h"
+#include "grad_aff/paa/DxtEncoder.h"
+#include "grad_aff/Parallel.h"
+
+#include <cstring>
+#include <mutex>
 
 #include <boost/gil.hpp>
 #include <boost/gil/extension/numeric/resample.hpp>
@@ -22,21 +28,70 @@ using namespace OIIO;
 
 using namespace grad_aff;
 
+namespace {
+    std::vector<uint8_t> lzoDecompress(const std::vector<uint8_t>& data, size_t uncompressedSize) {
+        auto lzoUncompressed = std::vector<uint8_t>(uncompressedSize);
+
+        size_t decompressedSize = 0;
+        auto error = lzokay::decompress(data.data(), data.size(), lzoUncompressed.data(), lzoUncompressed.size(), decompressedSize);
+
+        if (error != lzokay::EResult::Success) {
+            throw std::runtime_error("LZO Decompression failed");
+        }
+        lzoUncompressed.resize(decompressedSize);
+        return lzoUncompressed;
+    }
+
+    // rows of a mipmap resampled by one task
+    constexpr size_t mipmapBandHeight = 32;
+
+    // the destination to source mapping of bg::resize_view
+    bg::matrix3x2<double> resizeMapping(double srcWidth, double srcHeight, double dstWidth, double dstHeight) {
+        srcWidth = std::max(srcWidth - 1, 1.0);
+        srcHeight = std::max(srcHeight - 1, 1.0);
+        dstWidth = std::max(dstWidth - 1, 1.0);
+        dstHeight = std::max(dstHeight - 1, 1.0);
+        return bg::matrix3x2<double>::get_translate(-dstWidth / 2.0, -dstHeight / 2.0) *
+            bg::matrix3x2<double>::get_scale(srcWidth / dstWidth, srcHeight / dstHeight) *
+            bg::matrix3x2<double>::get_translate(srcWidth / 2.0, srcHeight / 2.0);
+    }
+
+    // resize mapping for a band of destination rows starting at top, gives the same samples as the whole view
+    struct RowBandMapping {
+        bg::matrix3x2<double> toSource;
+        int top;
+    };
+
+    bg::point<double> transform(const RowBandMapping& mapping, const bg::point<std::ptrdiff_t>& p) {
+        return bg::transform(mapping.toSource, bg::point<std::ptrdiff_t>(p.x, p.y + mapping.top));
+    }
+}
+
+namespace boost { namespace gil {
+    template<>
+    struct mapping_traits<RowBandMapping> {
+        using result_type = point<double>;
+    };
+} }
+
 grad_aff::Paa::Paa() {
     this->typeOfPax = TypeOfPaX::UNKNOWN;
 };
 
 void grad_aff::Paa::readPaa(std::string filename, bool peek) {
-    readPaa(std::make_shared<std::ifstream>(filename, std::ios::binary), peek);
+    auto reader = BinaryReader::fromFile(filename);
+    readPaa(reader, peek);
 }
 
 void grad_aff::Paa::readPaa(std::vector<uint8_t> data, bool peek) {
-    readPaa(std::make_shared<std::stringstream>(std::string(data.begin(), data.end())), peek);
+    auto reader = BinaryReader(std::move(data));
+    readPaa(reader, peek);
 }
 
-void grad_aff::Paa::readPaa(std::shared_ptr<std::istream> is, bool peek) {
-    is->seekg(0);
-    magicNumber = readBytes<uint16_t>(*is);
+void grad_aff::Paa::readPaa(BinaryReader& reader, bool peek) {
+    reader.seek(0);
+    // empty and unreadable files end up in the default case
+    magicNumber = reader.remaining() >= 2 ? readBytes<uint16_t>(reader) : 0;
     switch (magicNumber)
     {
     case 0xff01:
@@ -70,14 +125,15 @@ void grad_aff::Paa::readPaa(std::shared_ptr<std::istream> is, bool peek) {
         throw std::runtime_error("Invalid file/magic number");
         break;
     }
+    this->dxtType = typeOfPax;
 
     // Taggs
-    while (is->peek() != 0)
+    while (peekBytes<uint8_t>(reader) != 0)
     {
         Tagg tagg;
-        tagg.signature = readString(*is, 8);
-        tagg.dataLength = readBytes<uint32_t>(*is);
-        tagg.data = readBytes(*is, tagg.dataLength);
+        tagg.signature = readString(reader, 8);
+        tagg.dataLength = readBytes<uint32_t>(reader);
+        tagg.data = readBytes(reader, tagg.dataLength);
         taggs.push_back(tagg);
 
         if (tagg.signature == "GGATGALF") {
@@ -86,24 +142,24 @@ void grad_aff::Paa::readPaa(std::shared_ptr<std::istream> is, bool peek) {
     }
 
     // TODO
-    palette.dataLength = readBytes<uint16_t>(*is);
+    palette.dataLength = readBytes<uint16_t>(reader);
     if (palette.dataLength > 0) {
-        palette.data = readBytes(*is, palette.dataLength);
+        palette.data = readBytes(reader, palette.dataLength);
     }
 
     // MipMaps
-    while (peekBytes<uint16_t>(*is) != 0) {
+    while (peekBytes<uint16_t>(reader) != 0) {
         MipMap mipmap;
-        mipmap.width = readBytes<uint16_t>(*is);
-        mipmap.height = readBytes<uint16_t>(*is);
-        mipmap.dataLength = readBytesAsArmaUShort(*is);
+        mipmap.width = readBytes<uint16_t>(reader);
+        mipmap.height = readBytes<uint16_t>(reader);
+        mipmap.dataLength = readBytesAsArmaUShort(reader);
 
         if (peek) {
             mipMaps.push_back(mipmap);
             return;
         }
 
-        mipmap.data = readBytes(*is, mipmap.dataLength);
+        mipmap.data = readBytes(reader, mipmap.dataLength);
 
         // check if top most bit is set, which indicates lzo compression for DXT files
         if ((mipmap.width & 0x8000) != 0) {
@@ -115,67 +171,85 @@ void grad_aff::Paa::readPaa(std::shared_ptr<std::istream> is, bool peek) {
             mipmap.lzoCompressed = false;
         }
 
-        if (mipmap.lzoCompressed) {
-            auto uncompressedSize = (size_t)mipmap.width * mipmap.height;
-            if (typeOfPax == TypeOfPaX::DXT1) {
-                uncompressedSize /= 2;
+        if (typeOfPax == TypeOfPaX::DXT1 || typeOfPax == TypeOfPaX::DXT5) {
+            mipmap.dxtData = std::move(mipmap.data);
+            mipmap.data = {};
+            mipmap.decoded = false;
+            if (!lazyDecode) {
+                auto lzoCompressed = mipmap.lzoCompressed;
+                decodeMipMap(mipmap);
+                mipmap.dxtData = {};
+                mipmap.lzoCompressed = lzoCompressed;
             }
-            auto lzoUncompressed = std::vector<uint8_t>(uncompressedSize);
-
-            size_t decompressedSize = 0;
-            auto error = lzokay::decompress(mipmap.data.data(), mipmap.dataLength, lzoUncompressed.data(), lzoUncompressed.size(), decompressedSize);
-
-            if (error != lzokay::EResult::Success) {
-                throw std::runtime_error("LZO Decompression failed");
-            }
-
-            mipmap.data = std::vector<uint8_t>(lzoUncompressed.data(), lzoUncompressed.data() + decompressedSize);
-            mipmap.dataLength = decompressedSize;
-            mipmap.data.resize(mipmap.dataLength);
         }
+        else if (mipmap.lzoCompressed) {
+            mipmap.data = lzoDecompress(mipmap.data, (size_t)mipmap.width * mipmap.height);
+            mipmap.dataLength = (uint32_t)mipmap.data.size();
+        }
+        // TODO: other pax
 
-        // decompress
-        if (typeOfPax == TypeOfPaX::DXT1) {
-            // DXT1 compression ratio in this case is for whatever reason 8:1
-            size_t uncompressedSize = (size_t)mipmap.dataLength * 8;
-            auto uncompressedData = std::vector<squish::u8>(uncompressedSize);
+        mipMaps.push_back(mipmap);
+    }
+}
 
-            squish::DecompressImage(uncompressedData.data(), mipmap.width, mipmap.height, mipmap.data.data(), squish::kDxt1);
+void grad_aff::Paa::unpackMipMap(MipMap& mipMap) const {
+    if (!mipMap.lzoCompressed || mipMap.dxtData.empty()) {
+        return;
+    }
+    // DXT1 has 4 bits per pixel, DXT5 8
+    auto uncompressedSize = (size_t)mipMap.width * mipMap.height;
+    if (dxtType == TypeOfPaX::DXT1) {
+        uncompressedSize /= 2;
+    }
+    mipMap.dxtData = lzoDecompress(mipMap.dxtData, uncompressedSize);
+    mipMap.lzoCompressed = false;
+}
 
-            mipmap.dataLength = uncompressedSize;
-            mipmap.data = std::vector<uint8_t>(uncompressedData.data(), uncompressedData.data() + uncompressedSize);
-        }
-        else if (typeOfPax == TypeOfPaX::DXT5) {
-            // DXT5 compression ratio is 4:1
-            size_t uncompressedSize = (size_t)mipmap.dataLength * 4;
-            auto uncompressedData = std::vector<squish::u8>(uncompressedSize);
+void grad_aff::Paa::decodeMipMap(MipMap& mipMap) const {
+    if (mipMap.decoded) {
+        return;
+    }
+    unpackMipMap(mipMap);
 
-            squish::DecompressImage(uncompressedData.data(), mipmap.width, mipmap.height, mipmap.data.data(), squish::kDxt5);
+    auto uncompressedSize = (size_t)mipMap.width * mipMap.height * 4;
+    auto blockCount = (((size_t)mipMap.width + 3) / 4) * (((size_t)mipMap.height + 3) / 4);
+    if (mipMap.dxtData.size() < blockCount * (dxtType == TypeOfPaX::DXT1 ? 8 : 16)) {
+        throw std::runtime_error("DXT data is too short");
+    }
+    auto uncompressedData = std::vector<uint8_t>(uncompressedSize);
+    if (dxtType == TypeOfPaX::DXT1) {
+        decodeBc1(mipMap.dxtData.data(), mipMap.width, mipMap.height, uncompressedData.data());
+    }
+    else {
+        decodeBc3(mipMap.dxtData.data(), mipMap.width, mipMap.height, uncompressedData.data());
+    }
 
-            mipmap.dataLength = uncompressedSize;
-            mipmap.data = std::vector<uint8_t>(uncompressedData.data(), uncompressedData.data() + uncompressedSize);
-        }
-        // TODO: other pax
+    mipMap.data = std::move(uncompressedData);
+    mipMap.dataLength = (uint32_t)uncompressedSize;
+    mipMap.decoded = true;
+}
 
-        mipMaps.push_back(mipmap);
+void grad_aff::Paa::decodeMipMaps() {
+    for (auto& mipMap : mipMaps) {
+        decodeMipMap(mipMap);
     }
 }
 
-void grad_aff::Paa::writePaa(std::string fileName, TypeOfPaX typeOfPaX) {
+void grad_aff::Paa::writePaa(std::string fileName, TypeOfPaX typeOfPaX, DxtQuality dxtQuality) {
     // Write everything
     std::ofstream os(fileName, std::ios::binary);
-    writePaa(os, typeOfPaX);
+    writePaa(os, typeOfPaX, dxtQuality);
     os.close();
 }
 
-std::vector<uint8_t> grad_aff::Paa::writePaa(TypeOfPaX typeOfPax) {
+std::vector<uint8_t> grad_aff::Paa::writePaa(TypeOfPaX typeOfPax, DxtQuality dxtQuality) {
     std::stringstream os;
-    writePaa(os, typeOfPax);
+    writePaa(os, typeOfPax, dxtQuality);
     auto outputString = os.str();
     return std::vector<uint8_t>(outputString.data(), outputString.data() + outputString.length());
 }
 
-void grad_aff::Paa::writePaa(std::ostream& os, TypeOfPaX typeOfPaX) {
+void grad_aff::Paa::writePaa(std::ostream& os, TypeOfPaX typeOfPaX, DxtQuality dxtQuality) {
 
     if (mipMaps.size() <= 1)
         calculateMipmapsAndTaggs();
@@ -183,114 +257,112 @@ void grad_aff::Paa::writePaa(std::ostream& os, TypeOfPaX typeOfPaX) {
     std::vector<MipMap> encodedMipMaps = mipMaps;
 
     // Compression
-    this->typeOfPax = typeOfPaX;
-    if (this->typeOfPax == TypeOfPaX::UNKNOWN) {
-        this->typeOfPax = hasTransparency ? TypeOfPaX::DXT5 : TypeOfPaX::DXT1;
+    auto targetType = typeOfPaX;
+    if (targetType == TypeOfPaX::UNKNOWN) {
+        targetType = hasTransparency ? TypeOfPaX::DXT5 : TypeOfPaX::DXT1;
     }
 
+    // untouched DXT blocks in the target format are copied, everything else is encoded from the pixels
+    std::vector<bool> passthrough(encodedMipMaps.size());
+    for (size_t i = 0; i < encodedMipMaps.size(); i++) {
+        passthrough[i] = !encodedMipMaps[i].dxtData.empty() && dxtType == targetType;
+    }
+    this->typeOfPax = targetType;
     if (typeOfPax == TypeOfPaX::DXT5) {
-        for (auto& mipmap : encodedMipMaps) {
-            auto compressedDataLength = mipmap.dataLength / 4;
-            auto compressedData = std::vector<uint8_t>(compressedDataLength);
-
-            compressImage(reinterpret_cast<const uint8_t*>(mipmap.data.data()), (int)mipmap.width, (int)mipmap.height, (int)mipmap.width * 4, compressedData.data(), squish::kDxt5);
-
-            mipmap.data = compressedData;
-            mipmap.dataLength = compressedDataLength;
-        }
         magicNumber = 0xff05;
     }
     else if (typeOfPax == TypeOfPaX::DXT1) {
-        for (auto& mipmap : encodedMipMaps) {
-            auto compressedDataLength = mipmap.dataLength / 8;
-            auto compressedData = std::vector<uint8_t>(compressedDataLength);
-
-            compressImage(reinterpret_cast<const uint8_t*>(mipmap.data.data()), (int)mipmap.width, (int)mipmap.height, (int)mipmap.width * 4, compressedData.data(), squish::kDxt1);
-
-            mipmap.data = compressedData;
-            mipmap.dataLength = compressedDataLength;
-        }
         magicNumber = 0xff01;
     }
 
-    lzokay::Dict<> dict;
+    // Fast is the in house encoder, Normal and High pick the squish fit
+    bool isDxt = typeOfPax == TypeOfPaX::DXT1 || typeOfPax == TypeOfPaX::DXT5;
+    bool isDxt5 = typeOfPax == TypeOfPaX::DXT5;
+    int flags = (isDxt5 ? squish::kDxt5 : squish::kDxt1)
+        | (dxtQuality == DxtQuality::Normal ? squish::kColourRangeFit : squish::kColourClusterFit);
+    size_t bytesPerBlock = isDxt5 ? 16 : 8;
+
+    // every level is encoded and LZO compressed on its own, levels don't share any state
+    auto encodeMipMap = [&](size_t i) {
+        auto& mipmap = encodedMipMaps[i];
+        if (passthrough[i]) {
+            mipmap.data = std::move(mipmap.dxtData);
+            mipmap.dataLength = (uint32_t)mipmap.data.size();
+            // still compressed as read
+            if (mipmap.lzoCompressed) {
+                mipmap.width |= 0x8000;
+                return;
+            }
+        }
+        else {
+            decodeMipMap(mipmap);
+            if (isDxt) {
+                auto compressedDataLength = (uint32_t)(((mipmap.width + 3) / 4) * ((mipmap.height + 3) / 4) * bytesPerBlock);
+                auto compressedData = std::vector<uint8_t>(compressedDataLength);
+
+                if (dxtQuality == DxtQuality::Fast) {
+                    if (isDxt5) {
+                        encodeBc3(mipmap.data.data(), mipmap.width, mipmap.height, compressedData.data());
+                    }
+                    else {
+                        encodeBc1(mipmap.data.data(), mipmap.width, mipmap.height, compressedData.data());
+                    }
+                }
+                else {
+                    compressImage(reinterpret_cast<const uint8_t*>(mipmap.data.data()), (int)mipmap.width, (int)mipmap.height, (int)mipmap.width * 4, compressedData.data(), flags);
+                }
+
+                mipmap.data = std::move(compressedData);
+                mipmap.dataLength = compressedDataLength;
+            }
+        }
 
-    for (auto& encodedMipMap : encodedMipMaps) {
-        if (encodedMipMap.width > 128) {
-            encodedMipMap.lzoCompressed = true;
-            std::size_t estimatedSize = lzokay::compress_worst_size(encodedMipMap.data.size());
+        if (mipmap.width > 128) {
+            mipmap.lzoCompressed = true;
+            std::size_t estimatedSize = lzokay::compress_worst_size(mipmap.data.size());
             std::vector<unsigned char> outputData(estimatedSize);
             size_t compressedSize = 0;
 
-            auto error = lzokay::compress(encodedMipMap.data.data(), encodedMipMap.data.size(), outputData.data(), estimatedSize, compressedSize, dict);
+            // the dictionary is too big for the stack of a worker thread
+            auto dict = std::make_unique<lzokay::Dict<>>();
+            auto error = lzokay::compress(mipmap.data.data(), mipmap.data.size(), outputData.data(), estimatedSize, compressedSize, *dict);
             if (error < lzokay::EResult::Success) {
                 throw std::runtime_error("LZO Compression failed");
             }
 
-            encodedMipMap.data = std::vector<uint8_t>(outputData.data(), outputData.data() + compressedSize);
-            encodedMipMap.dataLength = compressedSize;
-
-            encodedMipMap.width |= 0x8000;
+            outputData.resize(compressedSize);
+            mipmap.data = std::move(outputData);
+            mipmap.dataLength = (uint32_t)compressedSize;
 
+            mipmap.width |= 0x8000;
         }
-    }
+    };
 
-    Tagg taggOffs;
-    taggOffs.signature = "GGATSFFO";
-
-
-    uint32_t initalOffset = 0;
-    initalOffset += 2; // magic
-
-    for (auto tagg : taggs) {
-        initalOffset += 8 + 4; // sig + size of length
-        initalOffset += 4; // tagg.dataLength;
-    }
-
-    initalOffset += 8 + 4 + 16 * 4; // sig + size of length + 16 * 4byte
-    initalOffset += 2; // palletteLength
-    if (palette.dataLength > 0) {
-        // TODO:
-    }
-    // initalOffset += 8;
-
-    std::vector<char> offsetAsChars(4);
-    int counter = 0;
-
-    for (auto& mipmap : encodedMipMaps) {
-        offsetAsChars = std::vector<char>(reinterpret_cast<char*>(&initalOffset), reinterpret_cast<char*>(&initalOffset) + 4);
-
-        for (int i = 0; i < 4; i++) {
-            taggOffs.data.push_back(offsetAsChars[i]);
-        }
-
-
-        initalOffset += mipmap.dataLength + 2 * 2 + 3;
-        counter++;
-    }
-    taggOffs.dataLength = taggOffs.data.size();
-
-    if (taggOffs.dataLength < 64) {
-        while (taggOffs.dataLength < 64) {
-            taggOffs.data.push_back(0x00);
-            taggOffs.data.push_back(0x00);
-            taggOffs.data.push_back(0x00);
-            taggOffs.data.push_back(0x00);
-            taggOffs.dataLength += 4;
-        }
-    }
+    auto startPosition = os.tellp();
 
     // Write magic
     writeBytes<uint16_t>(os, magicNumber);
+
+    // offsets read from a file are replaced by the new ones
+    Tagg taggOffs;
+    taggOffs.signature = "GGATSFFO";
+    auto isOffsetTagg = [&](const Tagg& tagg) { return tagg.signature == taggOffs.signature; };
+
     for (auto& tagg : taggs) {
+        if (isOffsetTagg(tagg)) {
+            continue;
+        }
         writeString(os, tagg.signature);
         writeBytes<uint32_t>(os, tagg.dataLength);
         writeBytes(os, tagg.data);
     }
 
-    // Write offset Tag
+    // Write offset Tag, at least 16 entries, filled in once the levels are written
+    taggOffs.data.resize(std::max<size_t>(encodedMipMaps.size(), 16) * 4);
+    taggOffs.dataLength = (uint32_t)taggOffs.data.size();
     writeString(os, taggOffs.signature);
     writeBytes<uint32_t>(os, taggOffs.dataLength);
+    auto offsetsPosition = os.tellp();
     writeBytes(os, taggOffs.data);
 
     writeBytes<uint16_t>(os, palette.dataLength);
@@ -298,19 +370,40 @@ void grad_aff::Paa::writePaa(std::ostream& os, TypeOfPaX typeOfPaX) {
         // TODO:
     }
 
-    for (auto& mipmap : encodedMipMaps) {
-        writeBytes<uint16_t>(os, mipmap.width);
-        writeBytes<uint16_t>(os, mipmap.height);
-        writeBytesAsArmaUShort(os, mipmap.dataLength);
-        writeBytes(os, mipmap.data);
-    }
+    // Levels are encoded in parallel, the largest first. Whichever task finishes a level
+    // writes out all levels that are ready in file order, so writing overlaps the encoding.
+    std::vector<bool> encoded(encodedMipMaps.size());
+    size_t nextToWrite = 0;
+    std::mutex writeMutex;
+    parallelFor(0, encodedMipMaps.size(), [&](size_t i) {
+        encodeMipMap(i);
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        encoded[i] = true;
+        for (; nextToWrite < encodedMipMaps.size() && encoded[nextToWrite]; nextToWrite++) {
+            auto& mipmap = encodedMipMaps[nextToWrite];
+            auto offset = (uint32_t)(os.tellp() - startPosition);
+            std::memcpy(taggOffs.data.data() + nextToWrite * 4, &offset, 4);
+
+            writeBytes<uint16_t>(os, mipmap.width);
+            writeBytes<uint16_t>(os, mipmap.height);
+            writeBytesAsArmaUShort(os, mipmap.dataLength);
+            writeBytes(os, std::move(mipmap.data));
+        }
+    });
 
     writeBytes<uint16_t>(os, 0x00);
     writeBytes<uint16_t>(os, 0x00);
     writeBytes<uint16_t>(os, 0x00);
+
+    auto endPosition = os.tellp();
+    os.seekp(offsetsPosition);
+    writeBytes(os, taggOffs.data);
+    os.seekp(endPosition);
 }
 
 void grad_aff::Paa::calculateMipmapsAndTaggs() {
+    decodeMipMap(mipMaps[0]);
     auto curWidth = mipMaps[0].width;
     auto curHeight = mipMaps[0].height;
 
@@ -322,28 +415,22 @@ void grad_aff::Paa::calculateMipmapsAndTaggs() {
             continue;
         }
 
-        auto dataCopy = mipMaps[level - 1].data;
-        auto view = bg::interleaved_view(curWidth, curHeight, (bg::rgba8_pixel_t*) dataCopy.data(), (size_t)curWidth * 4);
-
         auto newWidth = curWidth / 2;
         auto newHeight = curHeight / 2;
 
-        auto subimage = bg::rgba8_image_t(newWidth, newHeight);
-        auto subView = bg::view(subimage);
-        bg::resize_view(view, subView, bg::bilinear_sampler());
-
         MipMap mipmap;
         mipmap.width = newWidth;
         mipmap.height = newHeight;
-
-        auto it = subView.begin();
-        while (it != subView.end()) {
-            mipmap.data.push_back((*it)[0]);
-            mipmap.data.push_back((*it)[1]);
-            mipmap.data.push_back((*it)[2]);
-            mipmap.data.push_back((*it)[3]);
-            it++;
-        }
+        mipmap.data.resize((size_t)newWidth * newHeight * 4);
+
+        auto view = bg::interleaved_view(curWidth, curHeight, (const bg::rgba8_pixel_t*)mipMaps[level - 1].data.data(), (size_t)curWidth * 4);
+        auto subView = bg::interleaved_view(newWidth, newHeight, (bg::rgba8_pixel_t*)mipmap.data.data(), (size_t)newWidth * 4);
+        auto toSource = resizeMapping(curWidth, curHeight, newWidth, newHeight);
+        parallelFor(0, ((size_t)newHeight + mipmapBandHeight - 1) / mipmapBandHeight, [&](size_t band) {
+            auto top = (int)(band * mipmapBandHeight);
+            auto rows = std::min<int>(mipmapBandHeight, newHeight - top);
+            bg::resample_pixels(view, bg::subimage_view(subView, 0, top, newWidth, rows), RowBandMapping{ toSource, top }, bg::bilinear_sampler());
+        });
         mipmap.dataLength = mipmap.data.size();
         mipMaps.push_back(mipmap);
 
@@ -403,32 +490,64 @@ void grad_aff::Paa::calculateMipmapsAndTaggs() {
 
 std::vector<uint8_t> grad_aff::Paa::getRawPixelData(uint8_t level)
 {
-    if (this->mipMaps.size() == 0 || this->mipMaps[0].data.size() == 0) {
+    if (this->mipMaps.size() == 0) {
         return {};
     } else {
+        decodeMipMap(this->mipMaps[level]);
         return this->mipMaps[level].data;
     }
 };
 
 std::array<uint8_t, 4> grad_aff::Paa::getRawPixelDataAt(size_t x, size_t y, uint8_t level) {
-    if (this->mipMaps.size() == 0 || this->mipMaps[0].data.size() == 0) {
+    if (this->mipMaps.size() == 0) {
         return {};
     }
-    else {
-        std::array<uint8_t, 4> result;
+    auto& mipMap = this->mipMaps[level];
+    std::array<uint8_t, 4> result;
+    if (mipMap.decoded) {
+        if (mipMap.data.empty()) {
+            return {};
+        }
         for (int i = 0; i < 4; i++) {
-            result[i] = this->mipMaps[level].data[x + y * mipMaps[level].width + i];
+            result[i] = mipMap.data[(x + y * mipMap.width) * 4 + i];
         }
         return result;
     }
+
+    // decode only the block holding x/y
+    unpackMipMap(mipMap);
+    auto isDxt1 = dxtType == TypeOfPaX::DXT1;
+    auto bytesPerBlock = isDxt1 ? 8 : 16;
+    auto block = (y / 4) * (((size_t)mipMap.width + 3) / 4) + x / 4;
+    if (x >= mipMap.width || y >= mipMap.height || (block + 1) * bytesPerBlock > mipMap.dxtData.size()) {
+        throw std::out_of_range("Pixel outside of the mipmap");
+    }
+    std::array<uint8_t, 64> blockPixels;
+    if (isDxt1) {
+        decodeBc1Block(mipMap.dxtData.data() + block * bytesPerBlock, blockPixels.data(), 16);
+    }
+    else {
+        decodeBc3Block(mipMap.dxtData.data() + block * bytesPerBlock, blockPixels.data(), 16);
+    }
+    auto pixel = ((y % 4) * 4 + x % 4) * 4;
+    for (int i = 0; i < 4; i++) {
+        result[i] = blockPixels[pixel + i];
+    }
+    return result;
 }
 
 void grad_aff::Paa::setRawPixelData(std::vector<uint8_t> data, uint8_t level) {
-    this->mipMaps[level].data = data;
+    auto& mipMap = this->mipMaps[level];
+    mipMap.data = data;
+    mipMap.dxtData = {};
+    mipMap.decoded = true;
 }
 void grad_aff::Paa::setRawPixelDataAt(size_t x, size_t y, std::array<uint8_t, 4> data, uint8_t level) {
+    auto& mipMap = this->mipMaps[level];
+    decodeMipMap(mipMap);
+    mipMap.dxtData = {};
     for (int i = 0; i < 4; i++) {
-        this->mipMaps[level].data[x + y * mipMaps[level].width + i] = data[i];
+        mipMap.data[(x + y * mipMap.width) * 4 + i] = data[i];
     }
 }
 
@@ -467,6 +586,7 @@ void grad_aff::Paa::writeImage(std::string filename, int level) {
         throw std::out_of_range(exStream.str());
     }
 
+    decodeMipMap(mipMaps[level]);
     int width = mipMaps[level].width;
     int height = mipMaps[level].height;
 
@@ -540,6 +660,7 @@ void grad_aff::setMipMap(Paa* paaPtr, uint16_t width, uint16_t height, uint8_t*
 }
 
 void grad_aff::getMipMap(Paa* paaPtr, uint16_t* width, uint16_t* height, uint8_t** data, size_t* dataSize, bool* lzoCompressed, int level) {
+    paaPtr->getRawPixelData(level);
     auto mipMap = paaPtr->mipMaps[level];
     *width = mipMap.width;
     *height = mipMap.height;
@@ -566,20 +687,20 @@ bool grad_aff::Paa::isPowerOfTwo(uint32_t x) noexcept  {
 }
 
 MipMap grad_aff::Paa::getOptimalMipMap(uint16_t cx) {
-    MipMap result;
-
-    if (mipMaps.size() < 0) {
-        return result;
+    if (mipMaps.size() == 0) {
+        return {};
     }
-    result = mipMaps[0];
-    for (const auto& mipMap : mipMaps)
+    // only the chosen level is decoded
+    size_t result = 0;
+    for (size_t i = 0; i < mipMaps.size(); i++)
     {
-        auto maxSize = std::max(mipMap.height, mipMap.width);
+        auto maxSize = std::max(mipMaps[i].height, mipMaps[i].width);
 
         if (maxSize < cx || maxSize == 4) {
-            return result;
+            break;
         }
-        result = mipMap;
+        result = i;
     }
-    return result;
+    decodeMipMap(mipMaps[result]);
+    return mipMaps[result];
 }
@@ -1,5 +1,7 @@
 #include "grad_aff/pbo/Pbo.h"
 
+#include "grad_aff/Parallel.h"
+
 #ifdef GRAD_AFF_USE_OPENSSL
 // Use the modern EVP API for hashing, compatible with OpenSSL 3.x
 #include <openssl/evp.h>
@@ -10,67 +12,155 @@
 
 namespace ba = boost::algorithm;
 
+namespace {
+    // Incremental SHA1, yields 20 zero bytes when built without OpenSSL
+    class Sha1 {
+#ifdef GRAD_AFF_USE_OPENSSL
+        EVP_MD_CTX* mdctx = nullptr;
+#endif
+    public:
+        Sha1() {
+#ifdef GRAD_AFF_USE_OPENSSL
+            // Updated SHA1 implementation using the OpenSSL 3.x EVP API
+            mdctx = EVP_MD_CTX_new();
+            if (!mdctx) {
+                throw std::runtime_error("Failed to create EVP_MD_CTX");
+            }
+            if (1 != EVP_DigestInit_ex(mdctx, EVP_sha1(), NULL)) {
+                EVP_MD_CTX_free(mdctx);
+                throw std::runtime_error("SHA1 Init failed");
+            }
+#endif
+        }
+
+        ~Sha1() {
+#ifdef GRAD_AFF_USE_OPENSSL
+            EVP_MD_CTX_free(mdctx);
+#endif
+        }
+
+        Sha1(const Sha1&) = delete;
+        Sha1& operator=(const Sha1&) = delete;
+
+        void update(const void* data, size_t size) {
+#ifdef GRAD_AFF_USE_OPENSSL
+            if (size > 0 && 1 != EVP_DigestUpdate(mdctx, data, size)) {
+                throw std::runtime_error("SHA1 Update failed");
+            }
+#else
+            (void)data;
+            (void)size;
+#endif
+        }
+
+        std::vector<uint8_t> final() {
+#ifdef GRAD_AFF_USE_OPENSSL
+            std::vector<uint8_t> digest(EVP_MD_size(EVP_sha1()));
+            unsigned int digestLength = 0;
+            if (1 != EVP_DigestFinal_ex(mdctx, digest.data(), &digestLength)) {
+                throw std::runtime_error("SHA1 Final failed");
+            }
+            digest.resize(digestLength);
+            return digest;
+#else
+            return std::vector<uint8_t>(20, 0);
+#endif
+        }
+    };
+}
+
 grad_aff::Pbo::Pbo(std::string pboFilename) {
-    this->is = std::make_shared<std::ifstream>(pboFilename, std::ios::binary);
+    this->reader = BinaryReader::fromFile(pboFilename);
+    this->filePath = pboFilename;
     this->pboName = ((fs::path)pboFilename).replace_extension("").string();
 };
 
 grad_aff::Pbo::Pbo(std::vector<uint8_t> data, std::string pboName) {
-    this->is = std::make_shared<std::stringstream>(std::string(data.begin(), data.end()));
+    // take ownership of the buffer instead of copying it
+    this->reader = BinaryReader(std::move(data));
     this->pboName = pboName;
 }
 
 void grad_aff::Pbo::readPbo(bool withData) {
-    is->seekg(0);
-    auto initalZero = readBytes(*is, 1);
+    reader.seek(0);
+    if (reader.remaining() < 5) {
+        throw std::runtime_error("Invalid file/magic number");
+    }
+    auto initalZero = readBytes(reader, 1);
     if (initalZero[0] != 0) {
         throw std::runtime_error("Invalid file/no inital zero");
     }
-    auto magicNumber = readBytes<uint32_t>(*is);
+    auto magicNumber = readBytes<uint32_t>(reader);
     if (magicNumber != 0x56657273) {
         throw std::runtime_error("Invalid file/magic number");
     }
 
-    auto sixteenZeros = readBytes(*is, 16);
-    while (peekBytes<uint8_t>(*is) != 0)
+    auto sixteenZeros = readBytes(reader, 16);
+    while (peekBytes<uint8_t>(reader) != 0)
     {
-        productEntries.insert({ readZeroTerminatedString(*is), readZeroTerminatedString(*is) });
+        productEntries.insert({ readZeroTerminatedString(reader), readZeroTerminatedString(reader) });
     }
 
-    readBytes<uint8_t>(*is);
+    readBytes<uint8_t>(reader);
 
     // Entry
-    while (peekBytes<uint16_t>(*is) != 0) {
+    // data follows in header order, a repeated name replaces the earlier entry but its data still takes space
+    uint64_t dataOffset = 0;
+    while (peekBytes<uint16_t>(reader) != 0) {
         auto entry = std::make_shared<Entry>();
-        entry->filename = ba::to_lower_copy(readZeroTerminatedString(*is));
-        entry->packingMethod = readBytes<uint32_t>(*is);
-        entry->orginalSize = readBytes<uint32_t>(*is);
-        entry->reserved = readBytes<uint32_t>(*is);
-        entry->timestamp = readBytes<uint32_t>(*is);
-        entry->dataSize = readBytes<uint32_t>(*is);
-        entries.insert({ entry->filename.string(), entry });
+        entry->filename = ba::to_lower_copy(readZeroTerminatedString(reader));
+        entry->packingMethod = readBytes<uint32_t>(reader);
+        entry->orginalSize = readBytes<uint32_t>(reader);
+        entry->reserved = readBytes<uint32_t>(reader);
+        entry->timestamp = readBytes<uint32_t>(reader);
+        entry->dataSize = readBytes<uint32_t>(reader);
+        entry->dataOffset = dataOffset;
+        dataOffset += entry->dataSize;
+        entries[entry->filename.string()] = entry;
     }
 
-    auto nullBytes = readBytes(*is, 21);
-    dataPos = is->tellg();
+    auto nullBytes = readBytes(reader, 21);
+    dataPos = reader.tell();
+
+    // offsets were counted from the start of the data block
+    for (auto& entry : entries) {
+        entry.second->dataOffset += dataPos;
+    }
+    preHashPos = dataPos + dataOffset;
 
     if (!withData)
         return;
 
     for (auto& entry : entries) {
+        reader.seek(entry.second->dataOffset);
         entry.second->data = readEntry(*entry.second);
     }
 
-    preHashPos = is->tellg();
-    auto nullByte = readBytes(*is, 1);
-    hash = readBytes(*is, 20);
+    reader.seek(preHashPos);
+    auto nullByte = readBytes(reader, 1);
+    hash = readBytes(reader, 20);
 }
 
 std::vector<uint8_t> grad_aff::Pbo::readEntry(const Entry& entry) {
-    auto data = readBytes(*is, entry.dataSize);
-    if (entry.orginalSize != 0 && entry.orginalSize != entry.dataSize) {
+    // compressed entries are decoded straight from the buffer
+    return unpackEntry(entry, reader.readView(entry.dataSize));
+}
+
+bool grad_aff::Pbo::isCompressed(const Entry& entry) {
+    return entry.orginalSize != 0 && entry.orginalSize != entry.dataSize;
+}
+
+std::vector<uint8_t> grad_aff::Pbo::unpackEntry(const Entry& entry, std::vector<uint8_t> data) {
+    if (isCompressed(entry)) {
+        return unpackEntry(entry, ByteSpan(data));
+    }
+    return data;
+}
+
+std::vector<uint8_t> grad_aff::Pbo::unpackEntry(const Entry& entry, ByteSpan data) {
+    if (isCompressed(entry)) {
         std::vector<uint8_t> uncompressed;
-        if (readLzss(data, uncompressed) == entry.dataSize) {
+        if (readLzss(data, uncompressed, entry.orginalSize, false) == entry.dataSize) {
             return uncompressed;
         }
         else {
@@ -78,54 +168,56 @@ std::vector<uint8_t> grad_aff::Pbo::readEntry(const Entry& entry) {
         }
     }
     else {
-        return data;
+        return data.toVector();
     }
 }
 
 #ifdef GRAD_AFF_USE_OPENSSL
 bool grad_aff::Pbo::checkHash() {
-    if (preHashPos == 0)
-        readPbo(true);
-
-    is->seekg(0);
-    auto rawPboData = readBytes(*is, preHashPos);
-
-    // Updated SHA1 implementation using the OpenSSL 3.x EVP API
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX for hash check");
-    }
-
-    if (1 != EVP_DigestInit_ex(mdctx, EVP_sha1(), NULL)) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("SHA1 Init failed during hash check!");
-    }
-
-    if (1 != EVP_DigestUpdate(mdctx, rawPboData.data(), rawPboData.size())) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("SHA1 Update failed during hash check!");
-    }
+    // Only the header is needed, the data is hashed as stored without unpacking anything
+    if (entries.size() == 0)
+        readPbo(false);
 
-    std::vector<uint8_t> calculatedHash(EVP_MD_size(EVP_sha1()));
-    unsigned int digest_len;
+    size_t hashedSize = preHashPos;
+    Sha1 sha1;
 
-    if (1 != EVP_DigestFinal_ex(mdctx, calculatedHash.data(), &digest_len)) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("SHA1 Final failed during hash check!");
+    auto buffer = reader.getBuffer();
+    if (buffer.size() < hashedSize + 21) {
+        return false;
     }
+    sha1.update(buffer.data(), hashedSize);
+    hash = buffer.subspan(hashedSize + 1, 20).toVector();
 
-    EVP_MD_CTX_free(mdctx);
-
-    if (digest_len != hash.size()) {
-        return false; // Should not happen for SHA1 (20 bytes)
-    }
+    return sha1.final() == hash;
+}
 
-    return (calculatedHash == hash);
+std::vector<bool> grad_aff::Pbo::checkHashes(const std::vector<fs::path>& pboPaths) {
+    // std::vector<bool> packs bits and can't be written from several threads
+    std::vector<uint8_t> results(pboPaths.size(), 0);
+    parallelFor(0, pboPaths.size(), [&pboPaths, &results](size_t i) {
+        try {
+            Pbo pbo(pboPaths[i].string());
+            results[i] = pbo.checkHash();
+        }
+        catch (const std::exception&) {
+            results[i] = false;
+        }
+    });
+    return std::vector<bool>(results.begin(), results.end());
 }
 #endif
 
-void grad_aff::Pbo::extractPbo(fs::path outPath)
+void grad_aff::Pbo::extractPbo(fs::path outPath, size_t maxInFlightBytes)
 {
+    if (entries.size() == 0) {
+        this->readPbo(false);
+    }
+
+    std::vector<std::shared_ptr<Entry>> entryList;
+    std::vector<fs::path> outPaths;
+    entryList.reserve(entries.size());
+    outPaths.reserve(entries.size());
+
     for (auto& entryPair : entries) {
         const auto& entry = entryPair.second;
 
@@ -136,14 +228,61 @@ void grad_aff::Pbo::extractPbo(fs::path outPath)
         fs::path finalOutPath = outPath / normalizedPathStr;
         fs::path parentDirectory = finalOutPath.parent_path();
 
-        // Create the directory structure if it doesn't already exist.
+        // Create the directory structure up front, the workers only write files.
         if (!parentDirectory.empty() && !fs::exists(parentDirectory)) {
             fs::create_directories(parentDirectory);
         }
 
-        std::ofstream ofs(finalOutPath, std::ios::binary);
-        ofs.write(reinterpret_cast<const char*>(entry->data.data()), entry->data.size());
-        ofs.close();
+        entryList.push_back(entry);
+        outPaths.push_back(finalOutPath);
+    }
+
+    size_t batchBegin = 0;
+    while (batchBegin < entryList.size()) {
+        // Collect entries until their raw + unpacked size exceeds the budget, at least one per batch
+        size_t batchEnd = batchBegin;
+        size_t batchBytes = 0;
+        while (batchEnd < entryList.size()) {
+            const auto& entry = entryList[batchEnd];
+            size_t entryBytes = entry->data.size() > 0 || !entry->sourcePath.empty() ? 0 : (size_t)entry->dataSize + entry->orginalSize;
+            if (batchEnd > batchBegin && batchBytes + entryBytes > maxInFlightBytes) {
+                break;
+            }
+            batchBytes += entryBytes;
+            batchEnd++;
+        }
+
+        parallelFor(batchBegin, batchEnd, [&](size_t i) {
+            const auto& entry = entryList[i];
+
+            // added files aren't in the archive yet
+            if (!entry->sourcePath.empty() && entry->data.size() == 0) {
+                fs::copy_file(entry->sourcePath, outPaths[i], fs::copy_options::overwrite_existing);
+                return;
+            }
+
+            std::vector<uint8_t> unpacked;
+            ByteSpan data = entry->data;
+            if (entry->data.size() == 0 && entry->dataSize > 0) {
+                auto raw = reader.getBuffer().subspan(entry->dataOffset, entry->dataSize);
+                if (!isCompressed(*entry)) {
+                    data = raw;
+                }
+                else {
+                    unpacked = unpackEntry(*entry, raw);
+                    data = unpacked;
+                }
+            }
+
+            std::ofstream ofs(outPaths[i], std::ios::binary);
+            if (!ofs) {
+                throw std::runtime_error("Couldn't open file for writing: " + outPaths[i].string());
+            }
+            ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+            ofs.close();
+        });
+
+        batchBegin = batchEnd;
     }
 }
 
@@ -156,42 +295,46 @@ void grad_aff::Pbo::extractSingleFile(fs::path entryName, fs::path outPath, bool
 
     // Normalize the input entry name for comparison, as PBO paths are case-insensitive.
     std::string lowerEntryName = ba::to_lower_copy(entryName.string());
-    std::replace(lowerEntryName.begin(), lowerEntryName.end(), '\\', '/'); // Internally compare with '/'
-
-    for (auto& entryPair : entries) {
-        auto& entry = entryPair.second;
-        
-        std::string currentEntryFilename = entry->filename.string();
-        std::replace(currentEntryFilename.begin(), currentEntryFilename.end(), '\\', '/');
-
-        if (currentEntryFilename == lowerEntryName) {
-            fs::path writePath;
-            if (fullPath) {
-                // Construct the full path using the OS-preferred separator.
-                std::string normalizedPathStr = entry->filename.string();
-                std::replace(normalizedPathStr.begin(), normalizedPathStr.end(), '\\', fs::path::preferred_separator);
-                writePath = outPath / normalizedPathStr;
-            }
-            else {
-                // Just use the filename component.
-                writePath = outPath / entry->filename.filename();
-            }
+    std::replace(lowerEntryName.begin(), lowerEntryName.end(), '/', '\\');
+
+    auto searchEntry = entries.find(lowerEntryName);
+    if (searchEntry == entries.end()) {
+        // Fall back to a scan for PBOs that store '/' as separator
+        searchEntry = std::find_if(entries.begin(), entries.end(), [&lowerEntryName](const auto& entryPair) {
+            std::string currentEntryFilename = entryPair.second->filename.string();
+            std::replace(currentEntryFilename.begin(), currentEntryFilename.end(), '/', '\\');
+            return currentEntryFilename == lowerEntryName;
+        });
+        if (searchEntry == entries.end()) {
+            return;
+        }
+    }
+    auto& entry = searchEntry->second;
 
-            if (entry->data.size() == 0) {
-                this->readSingleData(entry->filename);
-            }
+    fs::path writePath;
+    if (fullPath) {
+        // Construct the full path using the OS-preferred separator.
+        std::string normalizedPathStr = entry->filename.string();
+        std::replace(normalizedPathStr.begin(), normalizedPathStr.end(), '\\', fs::path::preferred_separator);
+        writePath = outPath / normalizedPathStr;
+    }
+    else {
+        // Just use the filename component.
+        writePath = outPath / entry->filename.filename();
+    }
 
-            auto parentDirectory = writePath.parent_path();
-            if (!parentDirectory.empty() && !fs::exists(parentDirectory)) {
-                fs::create_directories(parentDirectory);
-            }
+    if (entry->data.size() == 0) {
+        this->readSingleData(entry->filename);
+    }
 
-            std::ofstream ofs(writePath, std::ios::binary);
-            writeBytes(ofs, entry->data);
-            ofs.close();
-            return;
-        }
+    auto parentDirectory = writePath.parent_path();
+    if (!parentDirectory.empty() && !fs::exists(parentDirectory)) {
+        fs::create_directories(parentDirectory);
     }
+
+    std::ofstream ofs(writePath, std::ios::binary);
+    writeBytes(ofs, entry->data);
+    ofs.close();
 }
 
 
@@ -199,111 +342,232 @@ void grad_aff::Pbo::readSingleData(fs::path searchEntry) {
     if (entries.size() == 0) {
         this->readPbo(false);
     }
-    
-    is->seekg(this->dataPos);
 
-    std::streamoff currentOffset = 0;
+    auto entryPair = entries.find(searchEntry.string());
+    if (entryPair == entries.end()) {
+        return;
+    }
 
-    for (auto &entryPair : entries) {
-        auto& entry = entryPair.second;
-        if (entry->filename == searchEntry) {
-            is->seekg(this->dataPos); // Go to the start of the data block
-            is->seekg(currentOffset, std::ios::cur); // Seek to the specific file's data
-            entry->data = readEntry(*entry);
-            return; // Found and read the file, so we can exit.
+    auto& entry = entryPair->second;
+    // added files aren't in the archive yet
+    if (!entry->sourcePath.empty()) {
+        std::ifstream ifs(entry->sourcePath, std::ios::binary);
+        if (!ifs) {
+            throw std::runtime_error("Couldn't open file for reading: " + entry->sourcePath.string());
         }
-        currentOffset += entry->dataSize;
+        entry->data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        return;
     }
+    reader.seek(entry->dataOffset);
+    entry->data = readEntry(*entry);
 }
 
-void grad_aff::Pbo::writePbo(fs::path outPath) {
+void grad_aff::Pbo::writePbo(fs::path outPath, bool compress) {
 
     if (outPath != "" && !fs::exists(outPath)) {
         fs::create_directories(outPath);
     }
-    std::ofstream ofs(outPath / (pboName + ".pbo"), std::ios::binary);
+
+    // Write next to the target and rename at the end, so an archive can be repacked onto itself
+    auto pboPath = outPath / (pboName + ".pbo");
+    auto tmpPath = outPath / (pboName + ".pbo.tmp");
+    std::ofstream ofs(tmpPath, std::ios::binary);
+    if (!ofs) {
+        throw std::runtime_error("Couldn't open file for writing: " + tmpPath.string());
+    }
+
+    Sha1 sha1;
+    auto write = [&ofs, &sha1](const void* data, size_t size) {
+        sha1.update(data, size);
+        ofs.write(reinterpret_cast<const char*>(data), size);
+    };
+
+    std::stringstream header;
 
     // write magic
-    writeBytes(ofs, { 0x00 });
-    writeBytes<uint32_t>(ofs, 0x56657273);
+    writeBytes(header, { 0x00 });
+    writeBytes<uint32_t>(header, 0x56657273);
 
     // write zero
     for (int i = 0; i < 16; i++) {
-        writeBytes(ofs, { 0 });
+        writeBytes(header, { 0 });
     }
 
     // write header entries
     for (auto& headEntry : productEntries) {
-        writeZeroTerminatedString(ofs, headEntry.first);
-        writeZeroTerminatedString(ofs, headEntry.second);
+        writeZeroTerminatedString(header, headEntry.first);
+        writeZeroTerminatedString(header, headEntry.second);
+    }
+    writeBytes<uint8_t>(header, 0);
+
+    // Compress the new entries up front, the header needs the packed sizes
+    std::vector<std::vector<uint8_t>> packedData(entries.size());
+    if (compress) {
+        parallelFor(0, entries.size(), [this, &packedData](size_t i) {
+            auto& entry = entries.nth(i)->second;
+            std::vector<uint8_t> fileData;
+            if (!entry->sourcePath.empty() && entry->data.size() == 0) {
+                std::ifstream ifs(entry->sourcePath, std::ios::binary);
+                if (!ifs) {
+                    throw std::runtime_error("Couldn't open file for reading: " + entry->sourcePath.string());
+                }
+                fileData.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            }
+            auto& rawData = entry->data.size() > 0 ? entry->data : fileData;
+            if (rawData.empty()) {
+                return;
+            }
+
+            std::vector<uint8_t> packed;
+            writeLzss(rawData, packed);
+            // keep incompressible data as is, equal sizes would read as uncompressed
+            if (packed.size() < rawData.size()) {
+                packedData[i] = std::move(packed);
+            }
+        });
     }
-    writeBytes<uint8_t>(ofs, 0);
 
     // Write Header
-    for (auto& entryPair : entries) {
-        auto& entry = entryPair.second;
-        writeZeroTerminatedString(ofs, entry->filename.string());
-        writeBytes<uint32_t>(ofs, entry->packingMethod);
-        writeBytes<uint32_t>(ofs, entry->orginalSize);
-        writeBytes<uint32_t>(ofs, entry->reserved);
-        writeBytes<uint32_t>(ofs, entry->timestamp);
-        writeBytes<uint32_t>(ofs, entry->dataSize);
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto& entry = entries.nth(i)->second;
+        uint32_t packingMethod = 0;
+        uint32_t orginalSize = 0;
+        uint32_t dataSize = 0;
+        if (packedData[i].size() > 0) {
+            packingMethod = 0x43707273;
+            orginalSize = entry->data.size() > 0 ? (uint32_t)entry->data.size() : (uint32_t)fs::file_size(entry->sourcePath);
+            dataSize = (uint32_t)packedData[i].size();
+        }
+        else if (entry->data.size() > 0) {
+            dataSize = (uint32_t)entry->data.size();
+        }
+        else if (!entry->sourcePath.empty()) {
+            dataSize = (uint32_t)fs::file_size(entry->sourcePath);
+        }
+        else {
+            // not loaded from the source archive, gets copied as is
+            packingMethod = entry->packingMethod;
+            orginalSize = entry->orginalSize;
+            dataSize = entry->dataSize;
+        }
+
+        writeZeroTerminatedString(header, entry->filename.string());
+        writeBytes<uint32_t>(header, packingMethod);
+        writeBytes<uint32_t>(header, orginalSize);
+        writeBytes<uint32_t>(header, entry->reserved);
+        writeBytes<uint32_t>(header, entry->timestamp);
+        writeBytes<uint32_t>(header, dataSize);
     }
 
     for (int i = 0; i < 21; i++) {
-        writeBytes(ofs, { 0x00 });
+        writeBytes(header, { 0x00 });
     }
 
-    for (auto& entryPair : entries) {
-        writeBytes(ofs, entryPair.second->data);
+    auto headerString = header.str();
+    write(headerString.data(), headerString.size());
+
+    // Stream the data, entries added from disk are never held in memory as a whole
+    std::vector<char> buffer(1024 * 1024);
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto& entry = entries.nth(i)->second;
+        if (packedData[i].size() > 0) {
+            write(packedData[i].data(), packedData[i].size());
+        }
+        else if (entry->data.size() > 0) {
+            write(entry->data.data(), entry->data.size());
+        }
+        else if (!entry->sourcePath.empty()) {
+            std::ifstream ifs(entry->sourcePath, std::ios::binary);
+            if (!ifs) {
+                throw std::runtime_error("Couldn't open file for reading: " + entry->sourcePath.string());
+            }
+            while (ifs) {
+                ifs.read(buffer.data(), buffer.size());
+                write(buffer.data(), (size_t)ifs.gcount());
+            }
+        }
+        else if (entry->dataSize > 0) {
+            auto raw = reader.getBuffer().subspan(entry->dataOffset, entry->dataSize);
+            write(raw.data(), raw.size());
+        }
     }
-    ofs.flush();
-    auto preHashPos = ofs.tellp();
-    
-    writeBytes(ofs, { 0x00 });
-    ofs.close();
 
-    // Re-open to read for hashing
-    std::ifstream pbo_read_stream(outPath / (pboName + ".pbo"), std::ios::binary);
-    std::vector<char> buffer(preHashPos);
-    pbo_read_stream.read(buffer.data(), preHashPos);
-    pbo_read_stream.close();
+    auto calculatedHash = sha1.final();
 
-#ifdef GRAD_AFF_USE_OPENSSL
-    // Updated SHA1 implementation using the OpenSSL 3.x EVP API
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX for writing PBO");
+    writeBytes(ofs, { 0x00 });
+    writeBytes(ofs, calculatedHash);
+    ofs.close();
+    if (!ofs) {
+        throw std::runtime_error("Couldn't write file: " + tmpPath.string());
     }
 
-    if (1 != EVP_DigestInit_ex(mdctx, EVP_sha1(), NULL)) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("SHA1 Init failed during PBO write");
+    // an archive repacked onto itself is still mapped, release it so the rename can replace the file
+    auto replacesSource = !filePath.empty() && fs::exists(pboPath) && fs::equivalent(filePath, pboPath);
+    if (replacesSource) {
+        reader = BinaryReader();
+    }
+    try {
+        fs::rename(tmpPath, pboPath);
+    }
+    catch (...) {
+        if (replacesSource) {
+            reader = BinaryReader::fromFile(filePath);
+        }
+        throw;
+    }
+    if (replacesSource) {
+        // unloaded entries point into the old archive, continue with the new one
+        reader = BinaryReader::fromFile(pboPath);
+        entries.clear();
+        productEntries.clear();
+        readPbo(false);
     }
+}
+
+void grad_aff::Pbo::addFile(fs::path file) {
+    addFile(file, file.filename());
+}
+
+void grad_aff::Pbo::addFile(fs::path file, fs::path entryPath) {
+    auto entryName = ba::to_lower_copy(entryPath.string());
+    std::replace(entryName.begin(), entryName.end(), '/', '\\');
+
+    // Only the path and metadata are kept, the data is streamed in by writePbo
+    auto entry = std::make_shared<Entry>();
+    entry->filename = entryName;
+    entry->sourcePath = file;
+    entry->dataSize = (uint32_t)fs::file_size(file);
 
-    if (1 != EVP_DigestUpdate(mdctx, buffer.data(), buffer.size())) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("SHA1 Update failed during PBO write");
+    auto fileTime = fs::last_write_time(file);
+    auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+    entry->timestamp = (uint32_t)std::chrono::duration_cast<std::chrono::seconds>(systemTime.time_since_epoch()).count();
+
+    entries.erase(entryName);
+    entries.insert({ entryName, entry });
+}
+
+void grad_aff::Pbo::addDir(fs::path dir) {
+    std::vector<fs::path> files;
+    for (auto& dirEntry : fs::recursive_directory_iterator(dir)) {
+        if (dirEntry.is_regular_file()) {
+            files.push_back(dirEntry.path());
+        }
     }
-    
-    std::vector<uint8_t> calculatedHash(EVP_MD_size(EVP_sha1()));
-    unsigned int digest_len;
+    // directory iteration order is unspecified, keep archives reproducible
+    std::sort(files.begin(), files.end());
 
-    if (1 != EVP_DigestFinal_ex(mdctx, calculatedHash.data(), &digest_len)) {
-        EVP_MD_CTX_free(mdctx);
-        throw std::runtime_error("SHA1 Final failed during PBO write");
+    for (auto& file : files) {
+        addFile(file, fs::relative(file, dir));
     }
+}
 
-    EVP_MD_CTX_free(mdctx);
-#else
-    std::vector<uint8_t> calculatedHash(20, 0);
-#endif
-    std::ofstream ofsHash(outPath / (pboName + ".pbo"), std::ios::binary | std::ios::app);
-    writeBytes(ofsHash, calculatedHash);
-    ofsHash.close();
+void grad_aff::Pbo::removeFile(fs::path file) {
+    auto entryName = ba::to_lower_copy(file.string());
+    std::replace(entryName.begin(), entryName.end(), '/', '\\');
+    entries.erase(entryName);
 }
 
-std::vector<uint8_t> grad_aff::Pbo::getEntryData(fs::path entryPath) {
+std::shared_ptr<Entry> grad_aff::Pbo::findEntry(fs::path entryPath) {
     if (entries.size() == 0)
         readPbo(false);
 
@@ -313,23 +577,38 @@ std::vector<uint8_t> grad_aff::Pbo::getEntryData(fs::path entryPath) {
 
     auto searchEntry = entries.find(entryPath.string());
     if (searchEntry != entries.end()) {
-        if (searchEntry->second->data.size() == 0) {
-            readSingleData(searchEntry->second->filename);
-        }
-        return searchEntry->second->data;
+        return searchEntry->second;
     }
-    else {
+    return {};
+}
+
+std::vector<uint8_t> grad_aff::Pbo::getEntryData(fs::path entryPath) {
+    auto entry = findEntry(entryPath);
+    if (!entry) {
         return {};
     }
+    if (entry->data.size() == 0) {
+        readSingleData(entry->filename);
+    }
+    return entry->data;
 }
 
-bool grad_aff::Pbo::hasEntry(fs::path entryPath) {
-    if (entries.size() == 0)
-        readPbo(false);
+grad_aff::ByteSpan grad_aff::Pbo::getEntryView(fs::path entryPath) {
+    auto entry = findEntry(entryPath);
+    if (!entry) {
+        return {};
+    }
 
-    if (ba::istarts_with(entryPath.string(), productEntries["prefix"])) {
-        entryPath = (fs::path)ba::to_lower_copy(entryPath.string().substr(productEntries["prefix"].size() + 1));
+    if (entry->sourcePath.empty() && !isCompressed(*entry)) {
+        return reader.getBuffer().subspan(entry->dataOffset, entry->dataSize);
+    }
+
+    if (entry->data.size() == 0) {
+        readSingleData(entry->filename);
     }
-    return entries.find(entryPath.string()) != entries.end();
+    return ByteSpan(entry->data);
 }
 
+bool grad_aff::Pbo::hasEntry(fs::path entryPath) {
+    return findEntry(entryPath) != nullptr;
+}
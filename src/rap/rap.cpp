@@ -5,43 +5,43 @@ grad_aff::Rap::Rap() {
 }
 
 grad_aff::Rap::Rap(std::string pboFilename) {
-    this->is = std::make_shared<std::ifstream>(pboFilename, std::ios::binary);
+    this->reader = BinaryReader::fromFile(pboFilename);
     this->rapName = ((fs::path)pboFilename).replace_extension("").string();
 };
 
 grad_aff::Rap::Rap(std::vector<uint8_t> data, std::string rapName) {
-    this->is = std::make_shared<std::stringstream>(std::string(data.begin(), data.end()));
+    this->reader = BinaryReader(std::move(data));
     this->rapName = rapName;
 }
 
-std::shared_ptr<RapArray> grad_aff::Rap::readArray(std::istream& is) {
+std::shared_ptr<RapArray> grad_aff::Rap::readArray(BinaryReader& reader) {
     auto ret = std::make_shared<RapArray>();
-    ret->type = readBytes<uint8_t>(is);
-    ret->name = readZeroTerminatedString(is);
-    ret->nElements = readCompressedInteger(is);
+    ret->type = readBytes<uint8_t>(reader);
+    ret->name = readZeroTerminatedString(reader);
+    ret->nElements = readCompressedInteger(reader);
     for (uint32_t i = 0; i < ret->nElements; i++) {
-        auto type = readBytes<uint8_t>(is);
+        auto type = readBytes<uint8_t>(reader);
         switch (type)
         {
         case 0:
         case 4:
         {
-            ret->arrayElements.push_back({ readZeroTerminatedString(is) });
+            ret->arrayElements.push_back({ readZeroTerminatedString(reader) });
             break;
         }
         case 1:
         {
-            ret->arrayElements.push_back({ readBytes<float_t>(is) });
+            ret->arrayElements.push_back({ readBytes<float_t>(reader) });
             break;
         }
         case 2:
         {
-            ret->arrayElements.push_back({ readBytes<int32_t>(is) });
+            ret->arrayElements.push_back({ readBytes<int32_t>(reader) });
             break;
         }
         case 3:
         {
-            ret->arrayElements.push_back({ *readArray(is) });
+            ret->arrayElements.push_back({ *readArray(reader) });
             break;
         }
         default:
@@ -51,10 +51,10 @@ std::shared_ptr<RapArray> grad_aff::Rap::readArray(std::istream& is) {
     return ret;
 }
 
-std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
+std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(BinaryReader& reader) {
     std::shared_ptr<ClassEntry> classEntry;
 
-    auto type = readBytes<uint8_t>(is);
+    auto type = readBytes<uint8_t>(reader);
     //auto name = readZeroTerminatedString(is);
 
     switch (type)
@@ -63,8 +63,8 @@ std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
     {
         auto rapClass = std::make_shared<RapClass>();
         rapClass->type = type;
-        rapClass->name = readZeroTerminatedString(is);
-        rapClass->offsetToClassBody = readBytes<uint32_t>(is);
+        rapClass->name = readZeroTerminatedString(reader);
+        rapClass->offsetToClassBody = readBytes<uint32_t>(reader);
         classEntry = rapClass;
         break;
     }
@@ -72,19 +72,19 @@ std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
     {
         auto rapValue = std::make_shared<RapValue>();
         rapValue->type = type;
-        rapValue->subType = readBytes<uint8_t>(is);
-        rapValue->name = readZeroTerminatedString(is);
+        rapValue->subType = readBytes<uint8_t>(reader);
+        rapValue->name = readZeroTerminatedString(reader);
         switch (rapValue->subType)
         {
         case 0:
         case 4:
-            rapValue->value = readZeroTerminatedString(is);
+            rapValue->value = readZeroTerminatedString(reader);
             break;
         case 1:
-            rapValue->value = readBytes<float_t>(is);
+            rapValue->value = readBytes<float_t>(reader);
             break;
         case 2:
-            rapValue->value = readBytes<int32_t>(is);
+            rapValue->value = readBytes<int32_t>(reader);
             break;
         case 3:
             // array, not used
@@ -100,8 +100,8 @@ std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
         //auto rapArray = std::make_shared<RapArray>();
         //is.seekg((name.size() + 1) * -1, std::ios::cur);
         //rapArray = readArray(is);
-        is.seekg(-1, std::ios::cur);
-        classEntry = readArray(is);
+        reader.seek(reader.tell() - 1);
+        classEntry = readArray(reader);
         //rapArray.type = type;
         //rapArray.name = name;
         //rapArray.
@@ -110,7 +110,7 @@ std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
     case 3:
     {
         auto rapExtern = std::make_shared<RapExtern>();
-        rapExtern->name = readZeroTerminatedString(is);
+        rapExtern->name = readZeroTerminatedString(reader);
         rapExtern->type = type;
         classEntry = rapExtern;
         break;
@@ -118,7 +118,7 @@ std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
     case 4:
     {
         auto rapDelete = std::make_shared<RapDelete>();
-        rapDelete->name = readZeroTerminatedString(is);
+        rapDelete->name = readZeroTerminatedString(reader);
         rapDelete->type = type;
         classEntry = rapDelete;
         break;
@@ -131,7 +131,7 @@ std::shared_ptr<ClassEntry> grad_aff::Rap::readClassEntry(std::istream& is) {
     return classEntry;
 }
 
-std::string grad_aff::Rap::readClassBody(std::istream& is, std::vector<std::shared_ptr<ClassEntry>>& classes) {
+std::string grad_aff::Rap::readClassBody(BinaryReader& reader, std::vector<std::shared_ptr<ClassEntry>>& classes) {
     /*
     for (auto& class_ : classes) {
         if (class_->type == 0) {
@@ -142,13 +142,13 @@ std::string grad_aff::Rap::readClassBody(std::istream& is, std::vector<std::shar
         }
     }*/
 
-    auto classBodyInheritedClassname = readZeroTerminatedString(is);
-    auto nEntries = readCompressedInteger(is);
+    auto classBodyInheritedClassname = readZeroTerminatedString(reader);
+    auto nEntries = readCompressedInteger(reader);
 
     //std::vector<std::shared_ptr<ClassEntry>> classEntries;
 
     for (uint32_t i = 0; i < nEntries; i++) {        
-        classes.push_back(readClassEntry(is));
+        classes.push_back(readClassEntry(reader));
     }
 
     for (auto& entry : classes) {
@@ -156,8 +156,8 @@ std::string grad_aff::Rap::readClassBody(std::istream& is, std::vector<std::shar
             auto rapClassPtr = std::static_pointer_cast<RapClass>(entry);
             auto classEntries = std::vector<std::shared_ptr<ClassEntry>>();
             
-            is.seekg(rapClassPtr->offsetToClassBody, std::ios::beg);
-            rapClassPtr->inheritedClassname = readClassBody(is, classEntries);
+            reader.seek(rapClassPtr->offsetToClassBody);
+            rapClassPtr->inheritedClassname = readClassBody(reader, classEntries);
             rapClassPtr->classEntries = classEntries;
         }
     }
@@ -172,18 +172,19 @@ void grad_aff::Rap::readRap() {
     //auto signature = readBytes(*is, 4);
     // TODO assert;
 
-    auto initalZero = readBytes<uint8_t>(*is);
-    auto rap = readString(*is, 3);
+    reader.seek(0);
+    auto initalZero = readBytes<uint8_t>(reader);
+    auto rap = readString(reader, 3);
 
     if (initalZero != 0 && rap != "raP") {
         // try lzss decompression
         try
         {
-            is->seekg(0);
-            std::vector<uint8_t> out;
-            auto ret = readLzssFile(*is, out);
-            if (ret > 0) {
-                this->is = std::make_shared<std::stringstream>(std::string(out.begin(), out.end()));
+            auto out = std::make_shared<std::vector<uint8_t>>();
+            auto ret = readLzss(reader.getBuffer(), *out, 0, false);
+            // -1 flags a checksum mismatch
+            if (ret != (size_t)-1) {
+                this->reader = BinaryReader(ByteSpan(*out), out);
                 readRap();
                 return;
             }
@@ -193,14 +194,14 @@ void grad_aff::Rap::readRap() {
         throw std::runtime_error("Invalid file!");
     }
 
-    auto always0 = readBytes<uint32_t>(*is);
+    auto always0 = readBytes<uint32_t>(reader);
     assert(always0 == 0);
-    auto always8 = readBytes<uint32_t>(*is);
+    auto always8 = readBytes<uint32_t>(reader);
     assert(always8 == 8);
 
-    auto offsetToEnums = readBytes<uint32_t>(*is);
+    auto offsetToEnums = readBytes<uint32_t>(reader);
 
-    auto cfgPatchInherited = readClassBody(*is, classEntries);
+    auto cfgPatchInherited = readClassBody(reader, classEntries);
 
     assert(cfgPatchInherited == "");
 
@@ -296,9 +297,9 @@ void grad_aff::Rap::parseConfig(fs::path path) {
     auto firstByte = readBytes<uint8_t>(file);
     file.seekg(0);
     if (firstByte == 0xFF) {
-        std::ifstream lzssFile(path, std::ios::binary);
+        auto lzssReader = BinaryReader::fromFile(path);
         std::vector<uint8_t> out;
-        if (readLzssFile(lzssFile, out) > 0) {
+        if (readLzss(lzssReader.getBuffer(), out, 0, false) > 0) {
             stringInput = std::string(out.begin(), out.end());
 
             std::ofstream fout("data.dat", std::ios::out | std::ios::binary);
@@ -0,0 +1,340 @@
+#include "grad_aff/wrp/Heightmap.h"
+
+#include "grad_aff/wrp/wrp.h"
+#include "grad_aff/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define GRAD_AFF_HEIGHTMAP_SSE2
+    #include <emmintrin.h>
+#endif
+
+grad_aff::Heightmap::Heightmap(std::vector<float_t> heights, uint32_t sizeX, uint32_t sizeY, float_t gridSize) {
+    if (sizeX < 2 || sizeY < 2 || heights.size() != (size_t)sizeX * sizeY) {
+        throw std::runtime_error("Heightmap needs at least 2x2 heights");
+    }
+    if (!(gridSize > 0)) {
+        throw std::runtime_error("Invalid grid size");
+    }
+    this->sizeX = sizeX;
+    this->sizeY = sizeY;
+    this->gridSize = gridSize;
+    this->invGridSize = 1.0f / gridSize;
+    this->heights = std::move(heights);
+    buildPyramid();
+}
+
+grad_aff::Heightmap::Heightmap(const Wrp& wrp) {
+    if (wrp.elevation.empty()) {
+        throw std::runtime_error("Elevation of the wrp isn't loaded");
+    }
+    *this = Heightmap(wrp.elevation, wrp.mapSizeX, wrp.mapSizeY, wrp.layerSizeX * wrp.layerCellSize / wrp.mapSizeX);
+}
+
+void grad_aff::Heightmap::buildPyramid() {
+    pyramid.clear();
+
+    PyramidLevel squares;
+    squares.sizeX = sizeX - 1;
+    squares.sizeY = sizeY - 1;
+    squares.minHeights.resize((size_t)squares.sizeX * squares.sizeY);
+    squares.maxHeights.resize(squares.minHeights.size());
+    parallelFor(0, squares.sizeY, [&](size_t y) {
+        for (size_t x = 0; x < squares.sizeX; x++) {
+            auto h00 = heights[y * sizeX + x];
+            auto h10 = heights[y * sizeX + x + 1];
+            auto h01 = heights[(y + 1) * sizeX + x];
+            auto h11 = heights[(y + 1) * sizeX + x + 1];
+            squares.minHeights[y * squares.sizeX + x] = std::min({ h00, h10, h01, h11 });
+            squares.maxHeights[y * squares.sizeX + x] = std::max({ h00, h10, h01, h11 });
+        }
+    });
+    pyramid.push_back(std::move(squares));
+
+    while (pyramid.back().sizeX > 1 || pyramid.back().sizeY > 1) {
+        const auto& previous = pyramid.back();
+        PyramidLevel level;
+        level.sizeX = (previous.sizeX + 1) / 2;
+        level.sizeY = (previous.sizeY + 1) / 2;
+        level.minHeights.resize((size_t)level.sizeX * level.sizeY);
+        level.maxHeights.resize(level.minHeights.size());
+        for (size_t y = 0; y < level.sizeY; y++) {
+            for (size_t x = 0; x < level.sizeX; x++) {
+                auto minHeight = INFINITY;
+                auto maxHeight = -INFINITY;
+                for (auto py = 2 * y; py < std::min<size_t>(2 * y + 2, previous.sizeY); py++) {
+                    for (auto px = 2 * x; px < std::min<size_t>(2 * x + 2, previous.sizeX); px++) {
+                        minHeight = std::min(minHeight, previous.minHeights[py * previous.sizeX + px]);
+                        maxHeight = std::max(maxHeight, previous.maxHeights[py * previous.sizeX + px]);
+                    }
+                }
+                level.minHeights[y * level.sizeX + x] = minHeight;
+                level.maxHeights[y * level.sizeX + x] = maxHeight;
+            }
+        }
+        pyramid.push_back(std::move(level));
+    }
+}
+
+// the SSE2 path in sampleHeights does the same operations in the same order
+void grad_aff::Heightmap::locate(float_t x, float_t y, uint32_t& cellX, uint32_t& cellY, float_t& fx, float_t& fy) const {
+    auto gx = x / gridSize;
+    auto gy = y / gridSize;
+    // also maps NaN to 0
+    gx = gx > 0 ? gx : 0;
+    gy = gy > 0 ? gy : 0;
+    gx = gx < (float_t)(sizeX - 1) ? gx : (float_t)(sizeX - 1);
+    gy = gy < (float_t)(sizeY - 1) ? gy : (float_t)(sizeY - 1);
+
+    auto cx = (float_t)(int32_t)gx;
+    auto cy = (float_t)(int32_t)gy;
+    cx = cx < (float_t)(sizeX - 2) ? cx : (float_t)(sizeX - 2);
+    cy = cy < (float_t)(sizeY - 2) ? cy : (float_t)(sizeY - 2);
+
+    cellX = (uint32_t)cx;
+    cellY = (uint32_t)cy;
+    fx = gx - cx;
+    fy = gy - cy;
+}
+
+bool grad_aff::Heightmap::empty() const noexcept {
+    return heights.empty();
+}
+
+uint32_t grad_aff::Heightmap::getSizeX() const noexcept {
+    return sizeX;
+}
+
+uint32_t grad_aff::Heightmap::getSizeY() const noexcept {
+    return sizeY;
+}
+
+float_t grad_aff::Heightmap::getGridSize() const noexcept {
+    return gridSize;
+}
+
+float_t grad_aff::Heightmap::getHeight(uint32_t x, uint32_t y) const {
+    if (x >= sizeX || y >= sizeY) {
+        throw std::out_of_range("Grid point outside of the heightmap");
+    }
+    return heights[(size_t)y * sizeX + x];
+}
+
+float_t grad_aff::Heightmap::sampleHeight(float_t x, float_t y) const {
+    if (empty()) {
+        return 0;
+    }
+    uint32_t cellX, cellY;
+    float_t fx, fy;
+    locate(x, y, cellX, cellY, fx, fy);
+
+    auto row = heights.data() + (size_t)cellY * sizeX + cellX;
+    auto h00 = row[0];
+    auto h10 = row[1];
+    auto h01 = row[sizeX];
+    auto h11 = row[sizeX + 1];
+    if (fx + fy <= 1) {
+        return h00 + (h10 - h00) * fx + (h01 - h00) * fy;
+    }
+    return h11 + (h01 - h11) * (1 - fx) + (h10 - h11) * (1 - fy);
+}
+
+float_t grad_aff::Heightmap::sampleBilinear(float_t x, float_t y) const {
+    if (empty()) {
+        return 0;
+    }
+    uint32_t cellX, cellY;
+    float_t fx, fy;
+    locate(x, y, cellX, cellY, fx, fy);
+
+    auto row = heights.data() + (size_t)cellY * sizeX + cellX;
+    auto bottom = row[0] + (row[1] - row[0]) * fx;
+    auto top = row[sizeX] + (row[sizeX + 1] - row[sizeX]) * fx;
+    return bottom + (top - bottom) * fy;
+}
+
+XYZTriplet grad_aff::Heightmap::sampleNormal(float_t x, float_t y) const {
+    if (empty()) {
+        return { 0, 1, 0 };
+    }
+    uint32_t cellX, cellY;
+    float_t fx, fy;
+    locate(x, y, cellX, cellY, fx, fy);
+
+    auto row = heights.data() + (size_t)cellY * sizeX + cellX;
+    auto h00 = row[0];
+    auto h10 = row[1];
+    auto h01 = row[sizeX];
+    auto h11 = row[sizeX + 1];
+
+    // slopes of the triangle
+    float_t dx, dy;
+    if (fx + fy <= 1) {
+        dx = (h10 - h00) * invGridSize;
+        dy = (h01 - h00) * invGridSize;
+    }
+    else {
+        dx = (h11 - h01) * invGridSize;
+        dy = (h11 - h10) * invGridSize;
+    }
+    auto length = std::sqrt(dx * dx + 1 + dy * dy);
+    return { -dx / length, 1 / length, -dy / length };
+}
+
+void grad_aff::Heightmap::sampleHeights(const float_t* x, const float_t* y, float_t* result, size_t count) const {
+    if (empty()) {
+        std::fill(result, result + count, 0.0f);
+        return;
+    }
+
+    size_t i = 0;
+#ifdef GRAD_AFF_HEIGHTMAP_SSE2
+    static_assert(sizeof(float_t) == 4, "SSE2 sampling needs 32 bit floats");
+    const auto grid = _mm_set1_ps(gridSize);
+    const auto zero = _mm_setzero_ps();
+    const auto one = _mm_set1_ps(1.0f);
+    const auto maxX = _mm_set1_ps((float_t)(sizeX - 1));
+    const auto maxY = _mm_set1_ps((float_t)(sizeY - 1));
+    const auto maxCellX = _mm_set1_ps((float_t)(sizeX - 2));
+    const auto maxCellY = _mm_set1_ps((float_t)(sizeY - 2));
+
+    for (; i + 4 <= count; i += 4) {
+        auto gx = _mm_div_ps(_mm_loadu_ps(x + i), grid);
+        auto gy = _mm_div_ps(_mm_loadu_ps(y + i), grid);
+        gx = _mm_min_ps(_mm_max_ps(gx, zero), maxX);
+        gy = _mm_min_ps(_mm_max_ps(gy, zero), maxY);
+
+        auto cx = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gx)), maxCellX);
+        auto cy = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gy)), maxCellY);
+        auto fx = _mm_sub_ps(gx, cx);
+        auto fy = _mm_sub_ps(gy, cy);
+
+        // no gather in SSE2, the corners are loaded per lane
+        alignas(16) int32_t cellX[4];
+        alignas(16) int32_t cellY[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(cellX), _mm_cvttps_epi32(cx));
+        _mm_store_si128(reinterpret_cast<__m128i*>(cellY), _mm_cvttps_epi32(cy));
+        alignas(16) float_t corners[4][4];
+        for (size_t lane = 0; lane < 4; lane++) {
+            auto row = heights.data() + (size_t)cellY[lane] * sizeX + cellX[lane];
+            corners[0][lane] = row[0];
+            corners[1][lane] = row[1];
+            corners[2][lane] = row[sizeX];
+            corners[3][lane] = row[sizeX + 1];
+        }
+        auto h00 = _mm_load_ps(corners[0]);
+        auto h10 = _mm_load_ps(corners[1]);
+        auto h01 = _mm_load_ps(corners[2]);
+        auto h11 = _mm_load_ps(corners[3]);
+
+        auto lower = _mm_add_ps(_mm_add_ps(h00, _mm_mul_ps(_mm_sub_ps(h10, h00), fx)), _mm_mul_ps(_mm_sub_ps(h01, h00), fy));
+        auto upper = _mm_add_ps(_mm_add_ps(h11, _mm_mul_ps(_mm_sub_ps(h01, h11), _mm_sub_ps(one, fx))), _mm_mul_ps(_mm_sub_ps(h10, h11), _mm_sub_ps(one, fy)));
+        auto isLower = _mm_cmple_ps(_mm_add_ps(fx, fy), one);
+        _mm_storeu_ps(result + i, _mm_or_ps(_mm_and_ps(isLower, lower), _mm_andnot_ps(isLower, upper)));
+    }
+#endif
+    for (; i < count; i++) {
+        result[i] = sampleHeight(x[i], y[i]);
+    }
+}
+
+bool grad_aff::Heightmap::lineOfSight(const XYZTriplet& from, const XYZTriplet& to) const {
+    if (empty()) {
+        return true;
+    }
+
+    auto pointAt = [&](float_t t) {
+        return XYZTriplet{ from[0] * (1 - t) + to[0] * t, from[1] * (1 - t) + to[1] * t, from[2] * (1 - t) + to[2] * t };
+    };
+    auto isBlocked = [&](float_t t) {
+        auto p = pointAt(t);
+        return sampleHeight(p[0], p[2]) > p[1];
+    };
+
+    // in grid units
+    auto gx0 = from[0] / gridSize;
+    auto gy0 = from[2] / gridSize;
+    auto gx1 = to[0] / gridSize;
+    auto gy1 = to[2] / gridSize;
+
+    const float_t segmentLength = 16;
+    auto segments = std::max<size_t>(1, (size_t)std::ceil(std::max(std::abs(gx1 - gx0), std::abs(gy1 - gy0)) / segmentLength));
+    for (size_t segment = 0; segment < segments; segment++) {
+        auto t0 = (float_t)segment / segments;
+        auto t1 = (float_t)(segment + 1) / segments;
+
+        // segments that stay above the terrain range of their area are skipped
+        auto a = pointAt(t0);
+        auto b = pointAt(t1);
+        auto range = getHeightRange(std::min(a[0], b[0]), std::min(a[2], b[2]), std::max(a[0], b[0]), std::max(a[2], b[2]));
+        if (std::min(a[1], b[1]) > range.second) {
+            continue;
+        }
+
+        // terrain minus ray is linear between grid lines and square diagonals,
+        // so checking the points where the ray crosses them is exact
+        auto crossingBlocked = [&](float_t u0, float_t u1) {
+            if (u0 == u1) {
+                return false;
+            }
+            auto ua = u0 + (u1 - u0) * t0;
+            auto ub = u0 + (u1 - u0) * t1;
+            for (auto k = std::ceil(std::min(ua, ub)); k <= std::max(ua, ub); k++) {
+                if (isBlocked((k - u0) / (u1 - u0))) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (isBlocked(t0) || isBlocked(t1) || crossingBlocked(gx0, gx1) || crossingBlocked(gy0, gy1) || crossingBlocked(gx0 + gy0, gx1 + gy1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::pair<float_t, float_t> grad_aff::Heightmap::getHeightRange(float_t minX, float_t minY, float_t maxX, float_t maxY) const {
+    if (empty()) {
+        return { 0.0f, 0.0f };
+    }
+    uint32_t x0, y0, x1, y1;
+    float_t fx, fy;
+    locate(std::min(minX, maxX), std::min(minY, maxY), x0, y0, fx, fy);
+    locate(std::max(minX, maxX), std::max(minY, maxY), x1, y1, fx, fy);
+
+    // go up until the rectangle spans at most 2x2 entries
+    size_t level = 0;
+    while (level + 1 < pyramid.size() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+        x0 >>= 1;
+        y0 >>= 1;
+        x1 >>= 1;
+        y1 >>= 1;
+        level++;
+    }
+
+    const auto& entries = pyramid[level];
+    auto minHeight = INFINITY;
+    auto maxHeight = -INFINITY;
+    for (auto y = y0; y <= y1; y++) {
+        for (auto x = x0; x <= x1; x++) {
+            minHeight = std::min(minHeight, entries.minHeights[(size_t)y * entries.sizeX + x]);
+            maxHeight = std::max(maxHeight, entries.maxHeights[(size_t)y * entries.sizeX + x]);
+        }
+    }
+    return { minHeight, maxHeight };
+}
+
+size_t grad_aff::Heightmap::getPyramidLevels() const noexcept {
+    return pyramid.size();
+}
+
+std::pair<float_t, float_t> grad_aff::Heightmap::getPyramidRange(size_t level, uint32_t x, uint32_t y) const {
+    const auto& entries = pyramid.at(level);
+    if (x >= entries.sizeX || y >= entries.sizeY) {
+        throw std::out_of_range("Pyramid entry outside of the level");
+    }
+    return { entries.minHeights[(size_t)y * entries.sizeX + x], entries.maxHeights[(size_t)y * entries.sizeX + x] };
+}
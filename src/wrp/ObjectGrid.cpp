@@ -0,0 +1,201 @@
+#include "grad_aff/wrp/ObjectGrid.h"
+
+#include "grad_aff/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+uint32_t grad_aff::ObjectGrid::cellIndexX(float_t x) const {
+    auto cell = cellSize > 0 ? std::floor(x / cellSize) : 0;
+    // also catches NaN
+    if (!(cell > 0)) {
+        return 0;
+    }
+    return cell >= cellsX ? cellsX - 1 : (uint32_t)cell;
+}
+
+uint32_t grad_aff::ObjectGrid::cellIndexY(float_t y) const {
+    auto cell = cellSize > 0 ? std::floor(y / cellSize) : 0;
+    if (!(cell > 0)) {
+        return 0;
+    }
+    return cell >= cellsY ? cellsY - 1 : (uint32_t)cell;
+}
+
+void grad_aff::ObjectGrid::build(const ObjectTable& objects, float_t cellSize, uint32_t cellsX, uint32_t cellsY) {
+    clear();
+
+    if (!(cellSize > 0) || cellsX == 0 || cellsY == 0) {
+        cellSize = 0;
+        cellsX = 1;
+        cellsY = 1;
+    }
+    // merge cells while they far outnumber the objects, cells stay multiples of the given size
+    while ((size_t)cellsX * cellsY > std::max<size_t>(objects.size(), 1) * 2) {
+        cellSize *= 2;
+        cellsX = (cellsX + 1) / 2;
+        cellsY = (cellsY + 1) / 2;
+    }
+    this->cellSize = cellSize;
+    this->cellsX = cellsX;
+    this->cellsY = cellsY;
+
+    const auto& positions = objects.getPositions();
+    std::vector<uint32_t> objectCells(positions.size());
+
+    const size_t blockSize = 64 * 1024;
+    parallelFor(0, (positions.size() + blockSize - 1) / blockSize, [&](size_t block) {
+        auto end = std::min(positions.size(), (block + 1) * blockSize);
+        for (size_t i = block * blockSize; i < end; i++) {
+            objectCells[i] = cellIndexY(positions[i][2]) * cellsX + cellIndexX(positions[i][0]);
+        }
+    });
+
+    // counting sort by cell, objects keep their table order within a cell
+    cellStart.assign((size_t)cellsX * cellsY + 1, 0);
+    for (auto cell : objectCells) {
+        cellStart[cell + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    cellObjects.resize(positions.size());
+    cellPositions.resize(positions.size());
+    std::vector<uint32_t> next(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < objectCells.size(); i++) {
+        auto slot = next[objectCells[i]]++;
+        cellObjects[slot] = (uint32_t)i;
+        cellPositions[slot] = { positions[i][0], positions[i][2] };
+    }
+}
+
+void grad_aff::ObjectGrid::clear() {
+    cellSize = 0;
+    cellsX = 0;
+    cellsY = 0;
+    cellStart.clear();
+    cellObjects.clear();
+    cellPositions.clear();
+}
+
+bool grad_aff::ObjectGrid::empty() const noexcept {
+    return cellObjects.empty();
+}
+
+void grad_aff::ObjectGrid::queryRect(float_t minX, float_t minY, float_t maxX, float_t maxY, std::vector<uint32_t>& result) const {
+    result.clear();
+    if (empty() || !(minX <= maxX) || !(minY <= maxY)) {
+        return;
+    }
+
+    auto x0 = cellIndexX(minX);
+    auto x1 = cellIndexX(maxX);
+    for (auto cy = cellIndexY(minY); cy <= cellIndexY(maxY); cy++) {
+        // a row of cells is one contiguous range
+        auto rowStart = (size_t)cy * cellsX;
+        for (auto i = cellStart[rowStart + x0]; i < cellStart[rowStart + x1 + 1]; i++) {
+            const auto& position = cellPositions[i];
+            if (position[0] >= minX && position[0] <= maxX && position[1] >= minY && position[1] <= maxY) {
+                result.push_back(cellObjects[i]);
+            }
+        }
+    }
+}
+
+void grad_aff::ObjectGrid::queryRadius(float_t x, float_t y, float_t radius, std::vector<uint32_t>& result) const {
+    result.clear();
+    if (empty() || !(radius >= 0)) {
+        return;
+    }
+
+    auto radiusSquared = radius * radius;
+    auto x0 = cellIndexX(x - radius);
+    auto x1 = cellIndexX(x + radius);
+    for (auto cy = cellIndexY(y - radius); cy <= cellIndexY(y + radius); cy++) {
+        auto rowStart = (size_t)cy * cellsX;
+        for (auto i = cellStart[rowStart + x0]; i < cellStart[rowStart + x1 + 1]; i++) {
+            auto dx = cellPositions[i][0] - x;
+            auto dy = cellPositions[i][1] - y;
+            if (dx * dx + dy * dy <= radiusSquared) {
+                result.push_back(cellObjects[i]);
+            }
+        }
+    }
+}
+
+void grad_aff::ObjectGrid::queryNearest(float_t x, float_t y, size_t k, std::vector<uint32_t>& result) const {
+    result.clear();
+    if (empty() || k == 0) {
+        return;
+    }
+
+    // max heap of the best candidates so far, squared distance and slot in cellObjects
+    std::priority_queue<std::pair<float_t, uint32_t>> best;
+    auto visitCell = [&](int64_t cx, int64_t cy) {
+        if (cx < 0 || cy < 0 || cx >= cellsX || cy >= cellsY) {
+            return;
+        }
+        auto cell = (size_t)cy * cellsX + (size_t)cx;
+        for (auto i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+            auto dx = cellPositions[i][0] - x;
+            auto dy = cellPositions[i][1] - y;
+            auto distance = dx * dx + dy * dy;
+            if (best.size() < k) {
+                best.push({ distance, i });
+            }
+            else if (distance < best.top().first) {
+                best.pop();
+                best.push({ distance, i });
+            }
+        }
+    };
+
+    int64_t centerX = cellIndexX(x);
+    int64_t centerY = cellIndexY(y);
+    auto maxRing = (int64_t)std::max(cellsX, cellsY);
+    for (int64_t ring = 0; ring <= maxRing; ring++) {
+        // cells with a chebyshev distance of ring to the center cell
+        for (auto cx = centerX - ring; cx <= centerX + ring; cx++) {
+            visitCell(cx, centerY - ring);
+            if (ring > 0) {
+                visitCell(cx, centerY + ring);
+            }
+        }
+        for (auto cy = centerY - ring + 1; cy <= centerY + ring - 1; cy++) {
+            visitCell(centerX - ring, cy);
+            visitCell(centerX + ring, cy);
+        }
+
+        // everything in the remaining rings is at least ring cells away
+        auto bound = ring * cellSize;
+        if (best.size() == k && best.top().first <= bound * bound) {
+            break;
+        }
+    }
+
+    result.resize(best.size());
+    for (auto i = best.size(); i > 0; i--) {
+        result[i - 1] = cellObjects[best.top().second];
+        best.pop();
+    }
+}
+
+std::vector<uint32_t> grad_aff::ObjectGrid::queryRect(float_t minX, float_t minY, float_t maxX, float_t maxY) const {
+    std::vector<uint32_t> result;
+    queryRect(minX, minY, maxX, maxY, result);
+    return result;
+}
+
+std::vector<uint32_t> grad_aff::ObjectGrid::queryRadius(float_t x, float_t y, float_t radius) const {
+    std::vector<uint32_t> result;
+    queryRadius(x, y, radius, result);
+    return result;
+}
+
+std::vector<uint32_t> grad_aff::ObjectGrid::queryNearest(float_t x, float_t y, size_t k) const {
+    std::vector<uint32_t> result;
+    queryNearest(x, y, k, result);
+    return result;
+}
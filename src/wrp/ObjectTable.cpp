@@ -0,0 +1,129 @@
+#include "grad_aff/wrp/ObjectTable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+void grad_aff::ObjectTable::readObjects(BinaryReader& reader, size_t count) {
+    clear();
+    auto records = reader.readView(count * GRAD_AFF_SIZE_OF_WRPOBJECT);
+
+    objectIds.resize(count);
+    modelIndices.resize(count);
+    positions.resize(count);
+    rotations.resize(count);
+
+    // id, model index, 3x3 rotation, position, 0x02
+    for (size_t i = 0; i < count; i++) {
+        auto record = records.data() + i * GRAD_AFF_SIZE_OF_WRPOBJECT;
+        std::memcpy(&objectIds[i], record, 4);
+        std::memcpy(&modelIndices[i], record + 4, 4);
+        std::memcpy(&rotations[i], record + 8, sizeof(ObjectRotation));
+        std::memcpy(&positions[i], record + 44, sizeof(XYZTriplet));
+
+        uint32_t static0x02 = 0;
+        std::memcpy(&static0x02, record + 56, 4);
+        assert(static0x02 == 0x02);
+    }
+
+    if (!std::is_sorted(objectIds.begin(), objectIds.end())) {
+        buildIdOrder();
+    }
+}
+
+void grad_aff::ObjectTable::addObject(const Object& object) {
+    auto index = (uint32_t)objectIds.size();
+    auto ascending = objectIds.empty() || objectIds.back() <= object.objectId;
+
+    objectIds.push_back(object.objectId);
+    modelIndices.push_back(object.modelIndex);
+    positions.push_back(object.transformMatrix[3]);
+    rotations.push_back({ object.transformMatrix[0], object.transformMatrix[1], object.transformMatrix[2] });
+
+    if (!idOrder.empty()) {
+        auto it = std::upper_bound(idOrder.begin(), idOrder.end(), object.objectId, [this](uint32_t id, uint32_t i) {
+            return id < objectIds[i];
+        });
+        idOrder.insert(it, index);
+    }
+    else if (!ascending) {
+        buildIdOrder();
+    }
+}
+
+void grad_aff::ObjectTable::reserve(size_t count) {
+    objectIds.reserve(count);
+    modelIndices.reserve(count);
+    positions.reserve(count);
+    rotations.reserve(count);
+}
+
+void grad_aff::ObjectTable::clear() {
+    objectIds.clear();
+    modelIndices.clear();
+    positions.clear();
+    rotations.clear();
+    idOrder.clear();
+}
+
+void grad_aff::ObjectTable::buildIdOrder() {
+    idOrder.resize(objectIds.size());
+    for (size_t i = 0; i < idOrder.size(); i++) {
+        idOrder[i] = (uint32_t)i;
+    }
+    // stable, so duplicate ids keep file order
+    std::stable_sort(idOrder.begin(), idOrder.end(), [this](uint32_t a, uint32_t b) {
+        return objectIds[a] < objectIds[b];
+    });
+}
+
+size_t grad_aff::ObjectTable::size() const noexcept {
+    return objectIds.size();
+}
+
+bool grad_aff::ObjectTable::empty() const noexcept {
+    return objectIds.empty();
+}
+
+Object grad_aff::ObjectTable::getObject(size_t index) const {
+    Object object;
+    object.objectId = objectIds.at(index);
+    object.modelIndex = modelIndices[index];
+    object.transformMatrix = { rotations[index][0], rotations[index][1], rotations[index][2], positions[index] };
+    object.static0x02 = 0x02;
+    return object;
+}
+
+size_t grad_aff::ObjectTable::findObject(uint32_t objectId) const {
+    if (idOrder.empty()) {
+        auto it = std::lower_bound(objectIds.begin(), objectIds.end(), objectId);
+        if (it != objectIds.end() && *it == objectId) {
+            return (size_t)(it - objectIds.begin());
+        }
+        return npos;
+    }
+
+    auto it = std::lower_bound(idOrder.begin(), idOrder.end(), objectId, [this](uint32_t i, uint32_t id) {
+        return objectIds[i] < id;
+    });
+    if (it != idOrder.end() && objectIds[*it] == objectId) {
+        return *it;
+    }
+    return npos;
+}
+
+const std::vector<uint32_t>& grad_aff::ObjectTable::getObjectIds() const noexcept {
+    return objectIds;
+}
+
+const std::vector<uint32_t>& grad_aff::ObjectTable::getModelIndices() const noexcept {
+    return modelIndices;
+}
+
+const std::vector<XYZTriplet>& grad_aff::ObjectTable::getPositions() const noexcept {
+    return positions;
+}
+
+const std::vector<ObjectRotation>& grad_aff::ObjectTable::getRotations() const noexcept {
+    return rotations;
+}
@@ -0,0 +1,321 @@
+#include "grad_aff/wrp/RoadGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+    float_t distance3(const XYZTriplet& a, const XYZTriplet& b) {
+        auto dx = b[0] - a[0];
+        auto dy = b[1] - a[1];
+        auto dz = b[2] - a[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+void grad_aff::RoadGraph::build(const std::vector<RoadNet>& roadNets, float_t weldDistance) {
+    clear();
+
+    // nodes hashed by their x/y cell, a vertex is welded to a node in the 3x3 cells around it
+    auto hashSize = weldDistance > 0 ? weldDistance : 1.0f;
+    auto weldSquared = weldDistance > 0 ? weldDistance * weldDistance : 0.0f;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> weldCells;
+    auto cellKey = [](int64_t x, int64_t y) {
+        return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+    };
+    auto weld = [&](const XYZTriplet& position) {
+        auto cx = (int64_t)std::floor(position[0] / hashSize);
+        auto cy = (int64_t)std::floor(position[2] / hashSize);
+        for (auto y = cy - 1; y <= cy + 1; y++) {
+            for (auto x = cx - 1; x <= cx + 1; x++) {
+                auto cell = weldCells.find(cellKey(x, y));
+                if (cell == weldCells.end()) {
+                    continue;
+                }
+                for (auto node : cell->second) {
+                    auto d = distance3(nodePositions[node], position);
+                    if (d * d <= weldSquared) {
+                        return node;
+                    }
+                }
+            }
+        }
+        auto node = (uint32_t)nodePositions.size();
+        nodePositions.push_back(position);
+        weldCells[cellKey(cx, cy)].push_back(node);
+        return node;
+    };
+
+    uint32_t part = 0;
+    for (const auto& roadNet : roadNets) {
+        for (const auto& roadPart : roadNet.roadParts) {
+            auto previous = npos;
+            for (const auto& position : roadPart.roadPositions) {
+                auto node = weld(position);
+                if (previous != npos && previous != node) {
+                    segmentNodes.push_back({ previous, node });
+                    segmentLengths.push_back(distance3(nodePositions[previous], nodePositions[node]));
+                    segmentParts.push_back(part);
+                }
+                previous = node;
+            }
+            part++;
+        }
+    }
+
+    // every segment is an edge in both directions
+    edgeStart.assign(nodePositions.size() + 1, 0);
+    for (const auto& nodes : segmentNodes) {
+        edgeStart[nodes[0] + 1]++;
+        edgeStart[nodes[1] + 1]++;
+    }
+    for (size_t n = 1; n < edgeStart.size(); n++) {
+        edgeStart[n] += edgeStart[n - 1];
+    }
+    edgeTargets.resize(segmentNodes.size() * 2);
+    edgeLengths.resize(segmentNodes.size() * 2);
+    std::vector<uint32_t> next(edgeStart.begin(), edgeStart.end() - 1);
+    for (size_t s = 0; s < segmentNodes.size(); s++) {
+        auto a = segmentNodes[s][0];
+        auto b = segmentNodes[s][1];
+        edgeTargets[next[a]] = b;
+        edgeLengths[next[a]++] = segmentLengths[s];
+        edgeTargets[next[b]] = a;
+        edgeLengths[next[b]++] = segmentLengths[s];
+    }
+
+    buildSegmentGrid();
+}
+
+void grad_aff::RoadGraph::buildSegmentGrid() {
+    if (segmentNodes.empty()) {
+        return;
+    }
+
+    auto minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (const auto& position : nodePositions) {
+        minX = std::min(minX, position[0]);
+        minY = std::min(minY, position[2]);
+        maxX = std::max(maxX, position[0]);
+        maxY = std::max(maxY, position[2]);
+    }
+    auto width = std::max(maxX - minX, 1.0f);
+    auto height = std::max(maxY - minY, 1.0f);
+
+    // around one segment per cell
+    cellSize = std::max(std::sqrt(width * height / segmentNodes.size()), 1.0f);
+    originX = minX;
+    originY = minY;
+    cellsX = (uint32_t)(width / cellSize) + 1;
+    cellsY = (uint32_t)(height / cellSize) + 1;
+
+    // a segment goes into every cell its bounding box touches
+    auto forEachCell = [&](size_t segment, auto&& f) {
+        const auto& a = nodePositions[segmentNodes[segment][0]];
+        const auto& b = nodePositions[segmentNodes[segment][1]];
+        auto x0 = cellIndexX(std::min(a[0], b[0]));
+        auto x1 = cellIndexX(std::max(a[0], b[0]));
+        auto y0 = cellIndexY(std::min(a[2], b[2]));
+        auto y1 = cellIndexY(std::max(a[2], b[2]));
+        for (auto y = y0; y <= y1; y++) {
+            for (auto x = x0; x <= x1; x++) {
+                f((size_t)y * cellsX + x);
+            }
+        }
+    };
+
+    cellStart.assign((size_t)cellsX * cellsY + 1, 0);
+    for (size_t s = 0; s < segmentNodes.size(); s++) {
+        forEachCell(s, [&](size_t cell) { cellStart[cell + 1]++; });
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    cellSegments.resize(cellStart.back());
+    std::vector<uint32_t> next(cellStart.begin(), cellStart.end() - 1);
+    for (size_t s = 0; s < segmentNodes.size(); s++) {
+        forEachCell(s, [&](size_t cell) { cellSegments[next[cell]++] = (uint32_t)s; });
+    }
+}
+
+uint32_t grad_aff::RoadGraph::cellIndexX(float_t x) const {
+    auto cell = std::floor((x - originX) / cellSize);
+    // also catches NaN
+    if (!(cell > 0)) {
+        return 0;
+    }
+    return cell >= cellsX ? cellsX - 1 : (uint32_t)cell;
+}
+
+uint32_t grad_aff::RoadGraph::cellIndexY(float_t y) const {
+    auto cell = std::floor((y - originY) / cellSize);
+    if (!(cell > 0)) {
+        return 0;
+    }
+    return cell >= cellsY ? cellsY - 1 : (uint32_t)cell;
+}
+
+void grad_aff::RoadGraph::clear() {
+    *this = {};
+}
+
+bool grad_aff::RoadGraph::empty() const noexcept {
+    return segmentNodes.empty();
+}
+
+size_t grad_aff::RoadGraph::getNodeCount() const noexcept {
+    return nodePositions.size();
+}
+
+size_t grad_aff::RoadGraph::getSegmentCount() const noexcept {
+    return segmentNodes.size();
+}
+
+bool grad_aff::RoadGraph::nearestRoad(float_t x, float_t y, RoadHit& hit) const {
+    if (empty()) {
+        return false;
+    }
+
+    auto best = INFINITY;
+    auto visitCell = [&](int64_t cx, int64_t cy) {
+        if (cx < 0 || cy < 0 || cx >= cellsX || cy >= cellsY) {
+            return;
+        }
+        auto cell = (size_t)cy * cellsX + (size_t)cx;
+        for (auto i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+            auto segment = cellSegments[i];
+            const auto& a = nodePositions[segmentNodes[segment][0]];
+            const auto& b = nodePositions[segmentNodes[segment][1]];
+            auto dx = b[0] - a[0];
+            auto dy = b[2] - a[2];
+            auto lengthSquared = dx * dx + dy * dy;
+            auto t = lengthSquared > 0 ? ((x - a[0]) * dx + (y - a[2]) * dy) / lengthSquared : 0.0f;
+            t = std::clamp(t, 0.0f, 1.0f);
+            auto px = a[0] + dx * t - x;
+            auto py = a[2] + dy * t - y;
+            auto distanceSquared = px * px + py * py;
+            if (distanceSquared < best) {
+                best = distanceSquared;
+                hit.segment = segment;
+                hit.t = t;
+            }
+        }
+    };
+
+    int64_t centerX = cellIndexX(x);
+    int64_t centerY = cellIndexY(y);
+    auto maxRing = (int64_t)std::max(cellsX, cellsY);
+    for (int64_t ring = 0; ring <= maxRing; ring++) {
+        for (auto cx = centerX - ring; cx <= centerX + ring; cx++) {
+            visitCell(cx, centerY - ring);
+            if (ring > 0) {
+                visitCell(cx, centerY + ring);
+            }
+        }
+        for (auto cy = centerY - ring + 1; cy <= centerY + ring - 1; cy++) {
+            visitCell(centerX - ring, cy);
+            visitCell(centerX + ring, cy);
+        }
+
+        // segments only seen in later rings are at least ring cells away
+        auto bound = ring * cellSize;
+        if (best <= bound * bound) {
+            break;
+        }
+    }
+
+    const auto& a = nodePositions[segmentNodes[hit.segment][0]];
+    const auto& b = nodePositions[segmentNodes[hit.segment][1]];
+    hit.distance = std::sqrt(best);
+    hit.position = { a[0] + (b[0] - a[0]) * hit.t, a[1] + (b[1] - a[1]) * hit.t, a[2] + (b[2] - a[2]) * hit.t };
+    return true;
+}
+
+uint32_t grad_aff::RoadGraph::nearestNode(float_t x, float_t y) const {
+    RoadHit hit;
+    if (!nearestRoad(x, y, hit)) {
+        return npos;
+    }
+    return segmentNodes[hit.segment][hit.t <= 0.5f ? 0 : 1];
+}
+
+float_t grad_aff::RoadGraph::shortestPath(uint32_t start, uint32_t goal, std::vector<uint32_t>& path) const {
+    path.clear();
+    if (start >= nodePositions.size() || goal >= nodePositions.size()) {
+        throw std::out_of_range("Invalid road node");
+    }
+
+    // straight lines never overestimate, segments are straight
+    auto heuristic = [&](uint32_t node) {
+        return distance3(nodePositions[node], nodePositions[goal]);
+    };
+
+    std::vector<float_t> cost(nodePositions.size(), INFINITY);
+    std::vector<uint32_t> previous(nodePositions.size(), npos);
+    // estimate, cost when queued, node
+    using Entry = std::tuple<float_t, float_t, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    cost[start] = 0;
+    open.emplace(heuristic(start), 0.0f, start);
+    while (!open.empty()) {
+        auto [estimate, queuedCost, node] = open.top();
+        open.pop();
+        if (node == goal) {
+            break;
+        }
+        // a shorter way to node was queued after this entry
+        if (queuedCost > cost[node]) {
+            continue;
+        }
+        for (auto e = edgeStart[node]; e < edgeStart[node + 1]; e++) {
+            auto target = edgeTargets[e];
+            auto targetCost = cost[node] + edgeLengths[e];
+            if (targetCost < cost[target]) {
+                cost[target] = targetCost;
+                previous[target] = node;
+                open.emplace(targetCost + heuristic(target), targetCost, target);
+            }
+        }
+    }
+
+    if (cost[goal] == INFINITY) {
+        return INFINITY;
+    }
+    for (auto node = goal; node != npos; node = previous[node]) {
+        path.push_back(node);
+    }
+    std::reverse(path.begin(), path.end());
+    return cost[goal];
+}
+
+const std::vector<XYZTriplet>& grad_aff::RoadGraph::getNodePositions() const noexcept {
+    return nodePositions;
+}
+
+const std::vector<uint32_t>& grad_aff::RoadGraph::getEdgeStart() const noexcept {
+    return edgeStart;
+}
+
+const std::vector<uint32_t>& grad_aff::RoadGraph::getEdgeTargets() const noexcept {
+    return edgeTargets;
+}
+
+const std::vector<float_t>& grad_aff::RoadGraph::getEdgeLengths() const noexcept {
+    return edgeLengths;
+}
+
+const std::vector<std::array<uint32_t, 2>>& grad_aff::RoadGraph::getSegmentNodes() const noexcept {
+    return segmentNodes;
+}
+
+const std::vector<float_t>& grad_aff::RoadGraph::getSegmentLengths() const noexcept {
+    return segmentLengths;
+}
+
+const std::vector<uint32_t>& grad_aff::RoadGraph::getSegmentParts() const noexcept {
+    return segmentParts;
+}
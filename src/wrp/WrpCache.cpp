@@ -0,0 +1,231 @@
+#include "grad_aff/wrp/WrpCache.h"
+
+#include "grad_aff/wrp/wrp.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t arrayAlignment = 16;
+
+    void pad(std::ostream& os) {
+        static const char zeros[arrayAlignment] = {};
+        auto misalignment = (size_t)os.tellp() % arrayAlignment;
+        if (misalignment != 0) {
+            os.write(zeros, arrayAlignment - misalignment);
+        }
+    }
+
+    // element size of every array, for the bounds check on open
+    constexpr std::array<size_t, grad_aff::WrpCache::ArrayCount> elementSizes = {
+        sizeof(float_t), sizeof(uint32_t), sizeof(uint32_t), sizeof(XYZTriplet), sizeof(ObjectRotation),
+        sizeof(uint64_t), sizeof(char),
+        sizeof(XYZTriplet), sizeof(uint32_t), sizeof(uint32_t), sizeof(float_t),
+        sizeof(std::array<uint32_t, 2>), sizeof(float_t), sizeof(uint32_t)
+    };
+}
+
+grad_aff::WrpCacheSource grad_aff::WrpCacheSource::fromFile(const fs::path& path) {
+    MemoryMappedFile file(path);
+    auto source = fromData(file.span());
+    source.time = (int64_t)fs::last_write_time(path).time_since_epoch().count();
+    return source;
+}
+
+grad_aff::WrpCacheSource grad_aff::WrpCacheSource::fromData(ByteSpan data) {
+    WrpCacheSource source;
+    source.size = data.size();
+    source.hash = hashData(data);
+    return source;
+}
+
+uint64_t grad_aff::WrpCacheSource::hashData(ByteSpan data) {
+    // FNV-1a over 8 byte words, then the tail
+    const uint64_t prime = 0x100000001b3;
+    uint64_t hash = 0xcbf29ce484222325;
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < data.size(); i++) {
+        hash = (hash ^ data[i]) * prime;
+    }
+    return hash;
+}
+
+grad_aff::WrpCache::WrpCache(const fs::path& path) {
+    file = std::make_shared<MemoryMappedFile>(path);
+    if (file->size() < sizeof(Header)) {
+        throw std::runtime_error("Invalid WRP cache: " + path.string());
+    }
+    header = reinterpret_cast<const Header*>(file->data());
+    if (header->magic != Header().magic || header->version != formatVersion) {
+        throw std::runtime_error("Invalid WRP cache: " + path.string());
+    }
+    for (size_t i = 0; i < ArrayCount; i++) {
+        const auto& entry = header->arrays[i];
+        if (entry.offset % arrayAlignment != 0 || entry.offset > file->size()
+            || entry.count > (file->size() - entry.offset) / elementSizes[i]) {
+            throw std::runtime_error("Invalid WRP cache: " + path.string());
+        }
+    }
+    auto modelOffsets = getArray<uint64_t>(ArrayModelOffsets);
+    if (modelOffsets.empty() || modelOffsets[modelOffsets.size() - 1] > header->arrays[ArrayModelChars].count) {
+        throw std::runtime_error("Invalid WRP cache: " + path.string());
+    }
+}
+
+void grad_aff::WrpCache::write(const Wrp& wrp, const fs::path& path, const WrpCacheSource& source) {
+    // Write next to the target and rename at the end, a running reader may still map the previous cache
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    std::ofstream ofs(tmpPath, std::ios::binary);
+    if (!ofs) {
+        throw std::runtime_error("Couldn't open " + tmpPath.string());
+    }
+
+    Header header;
+    header.source = source;
+    header.wrpVersion = wrp.wrpVersion;
+    header.appId = wrp.appId;
+    header.layerSizeX = wrp.layerSizeX;
+    header.layerSizeY = wrp.layerSizeY;
+    header.mapSizeX = wrp.mapSizeX;
+    header.mapSizeY = wrp.mapSizeY;
+    header.layerCellSize = wrp.layerCellSize;
+    header.maxObjectId = wrp.maxObjectId;
+    // placeholder without magic, so a partially written cache never opens
+    Header placeholder;
+    placeholder.magic = {};
+    ofs.write(reinterpret_cast<const char*>(&placeholder), sizeof(Header));
+
+    auto writeArray = [&](Array array, const auto& values) {
+        using T = typename std::decay_t<decltype(values)>::value_type;
+        pad(ofs);
+        header.arrays[array].offset = (uint64_t)ofs.tellp();
+        header.arrays[array].count = values.size();
+        ofs.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    };
+
+    writeArray(ArrayElevation, wrp.elevation);
+    writeArray(ArrayObjectIds, wrp.objects.getObjectIds());
+    writeArray(ArrayModelIndices, wrp.objects.getModelIndices());
+    writeArray(ArrayPositions, wrp.objects.getPositions());
+    writeArray(ArrayRotations, wrp.objects.getRotations());
+
+    std::vector<uint64_t> modelOffsets = { 0 };
+    std::string modelChars;
+    for (const auto& model : wrp.models) {
+        modelChars += model;
+        modelOffsets.push_back(modelChars.size());
+    }
+    writeArray(ArrayModelOffsets, modelOffsets);
+    writeArray(ArrayModelChars, modelChars);
+
+    const auto& roadGraph = wrp.roadGraph;
+    writeArray(ArrayRoadNodes, roadGraph.getNodePositions());
+    writeArray(ArrayEdgeStart, roadGraph.getEdgeStart());
+    writeArray(ArrayEdgeTargets, roadGraph.getEdgeTargets());
+    writeArray(ArrayEdgeLengths, roadGraph.getEdgeLengths());
+    writeArray(ArraySegmentNodes, roadGraph.getSegmentNodes());
+    writeArray(ArraySegmentLengths, roadGraph.getSegmentLengths());
+    writeArray(ArraySegmentParts, roadGraph.getSegmentParts());
+
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    ofs.close();
+    if (!ofs) {
+        throw std::runtime_error("Writing the WRP cache failed");
+    }
+
+    fs::rename(tmpPath, path);
+}
+
+bool grad_aff::WrpCache::isValidFor(const fs::path& sourcePath, bool compareHash) const {
+    std::error_code error;
+    auto size = fs::file_size(sourcePath, error);
+    if (error || size != header->source.size) {
+        return false;
+    }
+    auto time = fs::last_write_time(sourcePath, error);
+    if (error) {
+        return false;
+    }
+    if (!compareHash && (int64_t)time.time_since_epoch().count() == header->source.time) {
+        return true;
+    }
+    MemoryMappedFile source(sourcePath);
+    return WrpCacheSource::hashData(source.span()) == header->source.hash;
+}
+
+const grad_aff::WrpCache::Header& grad_aff::WrpCache::getHeader() const noexcept {
+    return *header;
+}
+
+grad_aff::Span<const float_t> grad_aff::WrpCache::getElevation() const {
+    return getArray<float_t>(ArrayElevation);
+}
+
+size_t grad_aff::WrpCache::getObjectCount() const {
+    return (size_t)header->arrays[ArrayObjectIds].count;
+}
+
+grad_aff::Span<const uint32_t> grad_aff::WrpCache::getObjectIds() const {
+    return getArray<uint32_t>(ArrayObjectIds);
+}
+
+grad_aff::Span<const uint32_t> grad_aff::WrpCache::getModelIndices() const {
+    return getArray<uint32_t>(ArrayModelIndices);
+}
+
+grad_aff::Span<const XYZTriplet> grad_aff::WrpCache::getPositions() const {
+    return getArray<XYZTriplet>(ArrayPositions);
+}
+
+grad_aff::Span<const ObjectRotation> grad_aff::WrpCache::getRotations() const {
+    return getArray<ObjectRotation>(ArrayRotations);
+}
+
+size_t grad_aff::WrpCache::getModelCount() const {
+    return (size_t)header->arrays[ArrayModelOffsets].count - 1;
+}
+
+std::string_view grad_aff::WrpCache::getModel(size_t index) const {
+    auto offsets = getArray<uint64_t>(ArrayModelOffsets);
+    if (index + 1 >= offsets.size() || offsets[index] > offsets[index + 1]) {
+        throw std::out_of_range("Invalid model index");
+    }
+    auto chars = getArray<char>(ArrayModelChars);
+    return std::string_view(chars.data() + offsets[index], (size_t)(offsets[index + 1] - offsets[index]));
+}
+
+grad_aff::Span<const XYZTriplet> grad_aff::WrpCache::getRoadNodePositions() const {
+    return getArray<XYZTriplet>(ArrayRoadNodes);
+}
+
+grad_aff::Span<const uint32_t> grad_aff::WrpCache::getRoadEdgeStart() const {
+    return getArray<uint32_t>(ArrayEdgeStart);
+}
+
+grad_aff::Span<const uint32_t> grad_aff::WrpCache::getRoadEdgeTargets() const {
+    return getArray<uint32_t>(ArrayEdgeTargets);
+}
+
+grad_aff::Span<const float_t> grad_aff::WrpCache::getRoadEdgeLengths() const {
+    return getArray<float_t>(ArrayEdgeLengths);
+}
+
+grad_aff::Span<const std::array<uint32_t, 2>> grad_aff::WrpCache::getRoadSegmentNodes() const {
+    return getArray<std::array<uint32_t, 2>>(ArraySegmentNodes);
+}
+
+grad_aff::Span<const float_t> grad_aff::WrpCache::getRoadSegmentLengths() const {
+    return getArray<float_t>(ArraySegmentLengths);
+}
+
+grad_aff::Span<const uint32_t> grad_aff::WrpCache::getRoadSegmentParts() const {
+    return getArray<uint32_t>(ArraySegmentParts);
+}
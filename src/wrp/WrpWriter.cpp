@@ -0,0 +1,310 @@
+#include "grad_aff/wrp/WrpWriter.h"
+
+#include "grad_aff/StreamUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    template<typename T>
+    void writeArray(std::ostream& os, const T* data, size_t count) {
+        os.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+    }
+
+    // data has to have size values, empty data is written as size zeros
+    void writeLZOSection(std::ostream& os, grad_aff::ByteSpan data, size_t size) {
+        if (data.empty() && size != 0) {
+            std::vector<uint8_t> zeros(size);
+            grad_aff::writeLZOCompressed(os, zeros);
+            return;
+        }
+        if (data.size() != size) {
+            throw std::runtime_error("Section size doesn't match the terrain size");
+        }
+        grad_aff::writeLZOCompressed(os, data);
+    }
+}
+
+grad_aff::WrpWriter::WrpWriter(std::ostream& os, uint32_t layerSizeX, uint32_t layerSizeY, uint32_t mapSizeX, uint32_t mapSizeY,
+    float_t layerCellSize, uint32_t appId, uint32_t version)
+    : os(os), layerSizeX(layerSizeX), layerSizeY(layerSizeY), mapSizeX(mapSizeX), mapSizeY(mapSizeY), layerCellSize(layerCellSize) {
+    if (os.tellp() == std::streampos(-1)) {
+        throw std::runtime_error("WrpWriter needs a seekable stream");
+    }
+    writeString(os, "OPRW");
+    writeBytes<uint32_t>(os, version);
+    if (version > 24) {
+        writeBytes<uint32_t>(os, appId);
+    }
+    writeBytes<uint32_t>(os, layerSizeX);
+    writeBytes<uint32_t>(os, layerSizeY);
+    writeBytes<uint32_t>(os, mapSizeX);
+    writeBytes<uint32_t>(os, mapSizeY);
+    writeBytes<float_t>(os, layerCellSize);
+}
+
+void grad_aff::WrpWriter::advance(Stage next) {
+    auto optional = [](Stage s) { return s == Stage::Objects || s == Stage::MapInfo; };
+    if (next < stage || (next == stage && !optional(next))) {
+        throw std::runtime_error("WRP sections have to be written in file order");
+    }
+    for (auto s = (int)stage + 1; s < (int)next; s++) {
+        if (!optional((Stage)s)) {
+            throw std::runtime_error("WRP sections have to be written in file order");
+        }
+    }
+    stage = next;
+}
+
+void grad_aff::WrpWriter::writeABPacket(const GridBlockTree& tree, uint32_t nodeIndex) {
+    const auto& node = tree.nodes[nodeIndex];
+    uint16_t flags = 0;
+    for (size_t i = 0; i < node.size(); i++) {
+        if (!(node[i] & GridBlockTree::leafFlag)) {
+            flags |= (uint16_t)(1 << i);
+        }
+    }
+    writeBytes<uint16_t>(os, flags);
+    for (auto child : node) {
+        if (child & GridBlockTree::leafFlag) {
+            auto leaf = tree.getLeaf(child & ~GridBlockTree::leafFlag);
+            writeArray(os, leaf.data(), leaf.size());
+        }
+        else {
+            writeABPacket(tree, child);
+        }
+    }
+}
+
+void grad_aff::WrpWriter::writeGridBlock(const GridBlockTree& tree) {
+    if (tree.empty()) {
+        writeBytes<uint8_t>(os, 0);
+        writeBytes<uint32_t>(os, 0);
+        return;
+    }
+    // the reader only knows 4 byte leaves
+    if (tree.leafSize != 4) {
+        throw std::runtime_error("Grid block leaves have to be 4 bytes");
+    }
+    writeBytes<uint8_t>(os, 1);
+    writeABPacket(tree, 0);
+}
+
+void grad_aff::WrpWriter::writeLayers(const GridBlockTree& geography, const GridBlockTree& cfgEnvSounds,
+    const std::vector<XYZTriplet>& peaks, const GridBlockTree& rvmatLayerIndex) {
+    advance(Stage::Layers);
+    writeGridBlock(geography);
+    writeGridBlock(cfgEnvSounds);
+    writeBytes<uint32_t>(os, (uint32_t)peaks.size());
+    writeArray(os, peaks.data(), peaks.size());
+    writeGridBlock(rvmatLayerIndex);
+}
+
+void grad_aff::WrpWriter::writeGrids(ByteSpan randomClutter, ByteSpan compressedBytes, Span<const float_t> elevation) {
+    advance(Stage::Grids);
+    auto mapSize = (size_t)mapSizeX * mapSizeY;
+    writeLZOSection(os, randomClutter, mapSize);
+    writeLZOSection(os, compressedBytes, mapSize);
+    // the reader doesn't expect an elevation stream for an empty map
+    if (mapSize != 0) {
+        writeLZOSection(os, ByteSpan(reinterpret_cast<const uint8_t*>(elevation.data()), elevation.size() * sizeof(float_t)), mapSize * sizeof(float_t));
+    }
+}
+
+void grad_aff::WrpWriter::writeModels(const std::vector<std::string>& rvmats, const std::vector<std::string>& models,
+    const std::vector<ClassedModel>& classedModels) {
+    advance(Stage::Models);
+    writeBytes<uint32_t>(os, (uint32_t)rvmats.size());
+    for (const auto& rvmat : rvmats) {
+        writeZeroTerminatedString(os, rvmat);
+        writeBytes<uint8_t>(os, 0);
+    }
+    writeBytes<uint32_t>(os, (uint32_t)models.size());
+    for (const auto& model : models) {
+        writeZeroTerminatedString(os, model);
+    }
+    writeBytes<uint32_t>(os, (uint32_t)classedModels.size());
+    for (const auto& classedModel : classedModels) {
+        writeZeroTerminatedString(os, classedModel.className);
+        writeZeroTerminatedString(os, classedModel.modelPath);
+        writeArray(os, classedModel.position.data(), classedModel.position.size());
+        writeBytes<uint32_t>(os, classedModel.unkonwn);
+    }
+}
+
+void grad_aff::WrpWriter::writeBlocks(const GridBlockTree& unknownGridBlock3, const GridBlockTree& unknownGridBlock4,
+    ByteSpan compressedBytes2, ByteSpan compressedBytes3) {
+    advance(Stage::Blocks);
+    writeGridBlock(unknownGridBlock3);
+    sizeOfObjectsPos = os.tellp();
+    writeBytes<uint32_t>(os, 0);
+    writeGridBlock(unknownGridBlock4);
+    sizeOfMapInfoPos = os.tellp();
+    writeBytes<uint32_t>(os, 0);
+    writeLZOSection(os, compressedBytes2, (size_t)layerSizeX * layerSizeY);
+    writeLZOSection(os, compressedBytes3, (size_t)mapSizeX * mapSizeY);
+    maxObjectIdPos = os.tellp();
+    writeBytes<uint32_t>(os, 0);
+    sizeOfRoadNetsPos = os.tellp();
+    writeBytes<uint32_t>(os, 0);
+}
+
+void grad_aff::WrpWriter::writeRoadPart(const RoadPart& roadPart) {
+    if (roadPart.roadPositions.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Road part has too many positions");
+    }
+    auto nRoadPositions = roadPart.roadPositions.size();
+    writeBytes<uint16_t>(os, (uint16_t)nRoadPositions);
+    writeArray(os, roadPart.roadPositions.data(), nRoadPositions);
+    auto flags = roadPart.flags;
+    flags.resize(nRoadPositions);
+    writeArray(os, flags.data(), nRoadPositions);
+    writeBytes<uint32_t>(os, 0);
+    writeZeroTerminatedString(os, roadPart.p3dModel);
+    writeArray(os, roadPart.transformMatrix.data(), roadPart.transformMatrix.size());
+}
+
+void grad_aff::WrpWriter::writeRoadNets(const std::vector<RoadNet>& roadNets) {
+    advance(Stage::RoadNets);
+    auto start = os.tellp();
+
+    // the file has one entry per layer cell, nets are sorted into the cell of their first position
+    auto cellOf = [&](float_t position, uint32_t cells) {
+        auto cell = std::floor(position / layerCellSize);
+        if (!(cell > 0)) {
+            return (size_t)0;
+        }
+        return cell >= cells ? (size_t)cells - 1 : (size_t)cell;
+    };
+    auto layerSize = (size_t)layerSizeX * layerSizeY;
+    std::vector<std::vector<const RoadPart*>> cells(layerSize);
+    for (const auto& roadNet : roadNets) {
+        if (roadNet.roadParts.empty()) {
+            continue;
+        }
+        if (layerSize == 0) {
+            throw std::runtime_error("Road nets need a layer grid");
+        }
+        const auto& first = roadNet.roadParts.front().roadPositions;
+        size_t cell = 0;
+        if (!first.empty()) {
+            cell = cellOf(first[0][0], layerSizeX) + cellOf(first[0][2], layerSizeY) * layerSizeX;
+        }
+        for (const auto& roadPart : roadNet.roadParts) {
+            cells[cell].push_back(&roadPart);
+        }
+    }
+
+    for (const auto& cell : cells) {
+        writeBytes<uint32_t>(os, (uint32_t)cell.size());
+        for (auto roadPart : cell) {
+            writeRoadPart(*roadPart);
+        }
+    }
+    roadNetsSize = (uint64_t)(os.tellp() - start);
+}
+
+void grad_aff::WrpWriter::writeObjects(const Object* objects, size_t count) {
+    advance(Stage::Objects);
+    for (size_t i = 0; i < count; i++) {
+        largestObjectId = std::max(largestObjectId, objects[i].objectId);
+    }
+    // Object matches the on disk record
+    writeArray(os, objects, count);
+    objectCount += count;
+}
+
+void grad_aff::WrpWriter::writeObjects(const std::vector<Object>& objects) {
+    writeObjects(objects.data(), objects.size());
+}
+
+void grad_aff::WrpWriter::writeObjects(const ObjectTable& objects) {
+    std::vector<Object> batch;
+    batch.reserve(std::min(objects.size(), objectBatchSize));
+    for (size_t i = 0; i < objects.size(); i += objectBatchSize) {
+        batch.clear();
+        auto end = std::min(objects.size(), i + objectBatchSize);
+        for (auto j = i; j < end; j++) {
+            batch.push_back(objects.getObject(j));
+        }
+        writeObjects(batch);
+    }
+}
+
+void grad_aff::WrpWriter::writeMapInfo(const MapInfo& mapInfo) {
+    advance(Stage::MapInfo);
+    auto start = os.tellp();
+    for (size_t i = 0; i < mapInfo.size(); i++) {
+        auto [mapType, index] = mapInfo.order[i];
+        writeBytes<uint32_t>(os, mapInfo.at(i).infoType);
+        switch (mapType) {
+        case 1: {
+            const auto& mapData = mapInfo.mapTypes1[index];
+            writeBytes<uint32_t>(os, mapData.objectId);
+            writeBytes<float_t>(os, mapData.x);
+            writeBytes<float_t>(os, mapData.y);
+            break;
+        }
+        case 2: {
+            const auto& mapData = mapInfo.mapTypes2[index];
+            writeBytes<uint32_t>(os, mapData.objectId);
+            writeArray(os, mapData.bounds.data(), mapData.bounds.size());
+            break;
+        }
+        case 3: {
+            const auto& mapData = mapInfo.mapTypes3[index];
+            writeBytes<uint32_t>(os, mapData.color);
+            writeBytes<uint32_t>(os, mapData.indicator);
+            writeArray(os, mapData.floats.data(), mapData.floats.size());
+            break;
+        }
+        case 4: {
+            const auto& mapData = mapInfo.mapTypes4[index];
+            writeBytes<uint32_t>(os, mapData.objectId);
+            writeArray(os, mapData.bounds.data(), mapData.bounds.size());
+            writeArray(os, mapData.color.data(), mapData.color.size());
+            break;
+        }
+        case 5: {
+            const auto& mapData = mapInfo.mapTypes5[index];
+            writeBytes<uint32_t>(os, mapData.objectId);
+            writeArray(os, mapData.floats.data(), mapData.floats.size());
+            break;
+        }
+        case 35: {
+            const auto& mapData = mapInfo.mapTypes35[index];
+            writeBytes<uint32_t>(os, mapData.objectId);
+            writeArray(os, mapData.floats.data(), mapData.floats.size());
+            writeBytes<uint8_t>(os, mapData.unknown);
+            break;
+        }
+        }
+    }
+    mapInfoSize += (uint64_t)(os.tellp() - start);
+}
+
+void grad_aff::WrpWriter::finish(uint32_t maxObjectId) {
+    advance(Stage::Done);
+    auto sizeOfObjects = objectCount * GRAD_AFF_SIZE_OF_WRPOBJECT;
+    if (sizeOfObjects > std::numeric_limits<uint32_t>::max() || mapInfoSize > std::numeric_limits<uint32_t>::max()
+        || roadNetsSize > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("WRP sections exceed 4 GB");
+    }
+
+    auto end = os.tellp();
+    auto patch = [&](std::streampos pos, uint32_t value) {
+        os.seekp(pos);
+        writeBytes<uint32_t>(os, value);
+    };
+    patch(sizeOfObjectsPos, (uint32_t)sizeOfObjects);
+    patch(sizeOfMapInfoPos, (uint32_t)mapInfoSize);
+    patch(maxObjectIdPos, maxObjectId != 0 ? maxObjectId : largestObjectId);
+    patch(sizeOfRoadNetsPos, (uint32_t)roadNetsSize);
+    os.seekp(end);
+    os.flush();
+    if (!os) {
+        throw std::runtime_error("Writing the WRP failed");
+    }
+}
@@ -1,65 +1,97 @@
 #include "grad_aff/wrp/wrp.h"
 
+#include "grad_aff/Parallel.h"
+#include "grad_aff/wrp/WrpWriter.h"
+
+#include <fstream>
+
 grad_aff::Wrp::Wrp(std::string wrpFilename) {
-    this->is = std::make_shared<std::ifstream>(wrpFilename, std::ios::binary);
+    this->reader = BinaryReader::fromFile(wrpFilename);
     this->wrpName = wrpFilename;
 };
 
 grad_aff::Wrp::Wrp(std::vector<uint8_t> data) {
-    this->is = std::make_shared<std::stringstream>(std::string(data.begin(), data.end()));
+    this->reader = BinaryReader(std::move(data));
 }
 
-std::shared_ptr<grad_aff::GridBlockTree> grad_aff::Wrp::readABPair(std::istream& ifs, size_t dataSize) {
-    std::vector<uint8_t> data;
-    data.reserve(dataSize);
-    for (size_t i = 0; i < dataSize; i++) {
-        data.push_back(readBytes<uint8_t>(ifs));
+uint32_t grad_aff::Wrp::readABPacket(BinaryReader& reader, GridBlockTree& tree, uint32_t depth) {
+    auto nodeIndex = (uint32_t)tree.nodes.size();
+    tree.nodes.emplace_back();
+    tree.levels = std::max(tree.levels, depth);
+
+    std::bitset<16> flagBitsSet(readBytes<uint16_t>(reader));
+    for (size_t i = 0; i < flagBitsSet.size();) {
+        if (flagBitsSet[i]) {
+            auto child = readABPacket(reader, tree, depth + 1);
+            tree.nodes[nodeIndex][i++] = child;
+            continue;
+        }
+        // consecutive leaves are stored back to back, read them in one go
+        size_t run = 1;
+        while (i + run < flagBitsSet.size() && !flagBitsSet[i + run]) {
+            run++;
+        }
+        auto firstLeaf = (uint32_t)tree.leafCount();
+        auto leaves = reader.readView(run * tree.leafSize);
+        tree.leafData.insert(tree.leafData.end(), leaves.begin(), leaves.end());
+        for (size_t j = 0; j < run; j++) {
+            tree.nodes[nodeIndex][i + j] = GridBlockTree::leafFlag | (firstLeaf + (uint32_t)j);
+        }
+        i += run;
     }
-    return std::make_shared<GridBlockTree>(true, data);
+    return nodeIndex;
 }
 
-std::shared_ptr<grad_aff::GridBlockTree> grad_aff::Wrp::readABPacket(std::istream& ifs, size_t dataSize) {
-    auto subTree = std::make_shared<GridBlockTree>();
-    auto flagBits = readBytes<uint16_t>(ifs);
-    std::bitset<16> flagBitsSet(flagBits);
-    for (int i = 0; i < flagBitsSet.size(); i++) {
+grad_aff::GridBlockTree grad_aff::Wrp::readGridBlock(BinaryReader& reader, size_t dataSize) {
+    GridBlockTree tree;
+    auto isPresent = readBytes<uint8_t>(reader);
+    if (!isPresent) {
+        auto nullBits = readBytes<uint32_t>(reader);
+        assert(nullBits == 0);
+        return tree;
+    }
+    tree.leafSize = (uint32_t)dataSize;
+    readABPacket(reader, tree, 1);
+    return tree;
+};
+
+void grad_aff::Wrp::skipABPacket(BinaryReader& reader, size_t dataSize) {
+    std::bitset<16> flagBitsSet(readBytes<uint16_t>(reader));
+    for (size_t i = 0; i < flagBitsSet.size(); i++) {
         if (flagBitsSet[i]) {
-            subTree->addChild(readABPacket(ifs, dataSize));
+            skipABPacket(reader, dataSize);
         }
         else {
-            subTree->addChild(readABPair(ifs, dataSize));
+            reader.skip(dataSize);
         }
     }
-    return subTree;
 }
 
-std::shared_ptr<grad_aff::GridBlockTree> grad_aff::Wrp::readGridBlock(std::istream& ifs, size_t dataSize) {
-    auto isPresent = readBytes<uint8_t>(ifs);
-    if (!isPresent) {
-        auto nullBits = readBytes<uint32_t>(ifs);
-        assert(nullBits == 0);
-        return {};
+void grad_aff::Wrp::skipGridBlock(BinaryReader& reader, size_t dataSize) {
+    if (!readBytes<uint8_t>(reader)) {
+        reader.skip(4);
     }
     else {
-        return readABPacket(ifs, dataSize);
+        skipABPacket(reader, dataSize);
     }
-};
+}
 
-void grad_aff::Wrp::readWrp()
+void grad_aff::Wrp::readWrp(uint32_t sections)
 {
     
     // TODO Checks
-    this->wrpTypeName = readString(*is, 4);
+    reader.seek(0);
+    this->wrpTypeName = reader.remaining() >= 4 ? readString(reader, 4) : "";
     if(this->wrpTypeName != "OPRW") {
         // try lzss decompression
         try
         {
-            is->seekg(0);
-            std::vector<uint8_t> out;
-            auto ret = readLzssFile(*is, out);
-            if (ret > 0) {
-                this->is = std::make_shared<std::stringstream>(std::string(out.begin(), out.end()));
-                readWrp();
+            auto out = std::make_shared<std::vector<uint8_t>>();
+            auto ret = readLzss(reader.getBuffer(), *out, 0, false);
+            // -1 flags a checksum mismatch
+            if (ret != (size_t)-1) {
+                this->reader = BinaryReader(ByteSpan(*out), out);
+                readWrp(sections);
                 return;
             }
         }
@@ -67,227 +99,453 @@ void grad_aff::Wrp::readWrp()
 
         throw std::runtime_error("Invalid file!");
     }
-    this->wrpVersion = readBytes<uint32_t>(*is);
+    this->loadedSections = 0;
+    this->wrpVersion = readBytes<uint32_t>(reader);
     // because why not right?
     // check which version
     if (wrpVersion > 24) {
-        this->appId = readBytes<uint32_t>(*is);
+        this->appId = readBytes<uint32_t>(reader);
     }
-    this->layerSizeX = readBytes<uint32_t>(*is);
-    this->layerSizeY = readBytes<uint32_t>(*is);
-    this->mapSizeX = readBytes<uint32_t>(*is);
-    this->mapSizeY = readBytes<uint32_t>(*is);
+    this->layerSizeX = readBytes<uint32_t>(reader);
+    this->layerSizeY = readBytes<uint32_t>(reader);
+    this->mapSizeX = readBytes<uint32_t>(reader);
+    this->mapSizeY = readBytes<uint32_t>(reader);
 
     this->mapSize = mapSizeX * mapSizeY;
     this->layerSize = layerSizeX * layerSizeY;
 
-    this->layerCellSize = readBytes<float_t>(*is);
-    this->geography = readGridBlock(*is, 4);
+    this->layerCellSize = readBytes<float_t>(reader);
 
-    this->cfgEnvSounds = readGridBlock(*is, 4);
-    auto nPeaks = readBytes<uint32_t>(*is);
+    auto gridBlock = [&](GridBlockTree& gridBlockTree, size_t slot) {
+        gridBlockOffsets[slot] = reader.tell();
+        if (sections & SectionGridBlocks) {
+            gridBlockTree = readGridBlock(reader, 4);
+        }
+        else {
+            gridBlockTree.clear();
+            skipGridBlock(reader, 4);
+        }
+    };
+    // only the boundaries are found here, the sections are decoded at the end
+    auto readOrSkip = [&](uint32_t section) {
+        sectionOffsets[sectionIndex(section)] = reader.tell();
+        skipSection(section);
+    };
 
-    peaks.resize(nPeaks);
+    gridBlock(this->geography, 0);
+    gridBlock(this->cfgEnvSounds, 1);
 
-    for (size_t i = 0; i < nPeaks; i++) {
-        peaks[i] = readXYZTriplet(*is);
-    }
+    auto nPeaks = readBytes<uint32_t>(reader);
 
-    this->rvmatLayerIndex = readGridBlock(*is, 4);
-    
-    this->randomClutter = readLZOCompressed(*is, mapSize).first;
-    this->compressedBytes = readLZOCompressed(*is, mapSize).first;
-    this->elevation = readLZOCompressed<float_t>(*is, (size_t)mapSize * 4).first;
+    this->peaks = readArray<XYZTriplet>(reader, nPeaks);
+
+    gridBlock(this->rvmatLayerIndex, 2);
+
+    readOrSkip(SectionRandomClutter);
+    readOrSkip(SectionCompressedBytes);
+    readOrSkip(SectionElevation);
 
-    auto nRvmats = readBytes<uint32_t>(*is);
+    auto nRvmats = readBytes<uint32_t>(reader);
     this->rvmats = std::vector<std::string>(nRvmats);
 
     for (size_t i = 0; i < nRvmats; i++) {
-        rvmats[i] = readZeroTerminatedString(*is);
-        bool b = readBytes<uint8_t>(*is) == 0;
+        rvmats[i] = readZeroTerminatedString(reader);
+        bool b = readBytes<uint8_t>(reader) == 0;
         assert(b);
     }
 
-    auto nModels = readBytes<uint32_t>(*is);
+    auto nModels = readBytes<uint32_t>(reader);
     this->models = std::vector<std::string>(nModels);
 
     for (size_t i = 0; i < nModels; i++) {
-        models[i] = readZeroTerminatedString(*is);
+        models[i] = readZeroTerminatedString(reader);
     }
 
-    auto nClassedModels = readBytes<uint32_t>(*is);
+    auto nClassedModels = readBytes<uint32_t>(reader);
     this->classedModels = std::vector<ClassedModel>(nClassedModels);
 
     for (size_t i = 0; i < nClassedModels; i++) {
         ClassedModel classedModel;
-        classedModel.className = readZeroTerminatedString(*is);
-        classedModel.modelPath = readZeroTerminatedString(*is);
-        classedModel.position = readXYZTriplet(*is);
-        classedModel.unkonwn = readBytes<uint32_t>(*is);
+        classedModel.className = readZeroTerminatedString(reader);
+        classedModel.modelPath = readZeroTerminatedString(reader);
+        classedModel.position = readXYZTriplet(reader);
+        classedModel.unkonwn = readBytes<uint32_t>(reader);
         classedModels[i] = classedModel;
     }
 
-    this->unknownGridBlock3 = readGridBlock(*is, 4);
-
-    this->sizeOfObjects = readBytes<uint32_t>(*is);
-
-    this->unknownGridBlock4 = readGridBlock(*is, 4);
+    gridBlock(this->unknownGridBlock3, 3);
 
-    this->sizeOfMapInfo = readBytes<uint32_t>(*is);
+    this->sizeOfObjects = readBytes<uint32_t>(reader);
 
-    this->compressedBytes2 = readLZOCompressed(*is, layerSize).first;
-    this->compressedBytes3 = readLZOCompressed(*is, mapSize).first;
+    gridBlock(this->unknownGridBlock4, 4);
 
-    this->maxObjectId = readBytes<uint32_t>(*is);
-    this->sizeOfRoadNets = readBytes<uint32_t>(*is);
+    this->sizeOfMapInfo = readBytes<uint32_t>(reader);
 
-    this->roadNets = std::vector<RoadNet>();// layerSize);
+    readOrSkip(SectionCompressedBytes2);
+    readOrSkip(SectionCompressedBytes3);
 
-    for (size_t i = 0; i < layerSize; i++) {
-        RoadNet roadNet;
-        roadNet.nRoadParts = readBytes<uint32_t>(*is);
+    this->maxObjectId = readBytes<uint32_t>(reader);
+    this->sizeOfRoadNets = readBytes<uint32_t>(reader);
 
-        roadNet.roadParts = std::vector<RoadPart>(roadNet.nRoadParts);
+    readOrSkip(SectionRoadNets);
+    readOrSkip(SectionObjects);
+    readOrSkip(SectionMapInfo);
 
-        for (size_t j = 0; j < roadNet.nRoadParts; j++) {
-            RoadPart roadPart;
-            roadPart.nRoadPositions = readBytes<uint16_t>(*is);
-
-            roadPart.roadPositions = std::vector<XYZTriplet>(roadPart.nRoadPositions);
+    if (sections & SectionGridBlocks) {
+        loadedSections |= SectionGridBlocks;
+    }
+    readSections(sections);
+}
 
-            size_t pos = is->tellg();
+void grad_aff::Wrp::loadSections(uint32_t sections) {
+    sections &= SectionAll & ~loadedSections;
+    if (sections == 0) {
+        return;
+    }
+    if (wrpTypeName != "OPRW") {
+        throw std::runtime_error("readWrp has to be called before loading sections");
+    }
 
-            if (roadPart.nRoadPositions > 10000) {
-                auto pos = is->tellg();
-                std::cout << pos << std::endl;
-            }
+    if (sections & SectionGridBlocks) {
+        std::array<GridBlockTree*, 5> gridBlocks = { &geography, &cfgEnvSounds, &rvmatLayerIndex, &unknownGridBlock3, &unknownGridBlock4 };
+        for (size_t i = 0; i < gridBlocks.size(); i++) {
+            reader.seek(gridBlockOffsets[i]);
+            *gridBlocks[i] = readGridBlock(reader, 4);
+        }
+        loadedSections |= SectionGridBlocks;
+    }
 
-            for (size_t k = 0; k < roadPart.nRoadPositions; k++) {
-                roadPart.roadPositions[k] = readXYZTriplet(*is);
-            }
-            auto additionalBytes = readBytes(*is, roadPart.nRoadPositions);
-            readBytes(*is, 4);
+    readSections(sections);
+}
 
-            roadPart.p3dModel = readZeroTerminatedString(*is);
+void grad_aff::Wrp::readSections(uint32_t sections) {
+    std::vector<uint32_t> pending;
+    std::vector<BinaryReader> readers;
+    for (uint32_t section = SectionRandomClutter; section <= SectionMapInfo; section <<= 1) {
+        if (sections & section) {
+            pending.push_back(section);
+            readers.push_back(reader);
+            readers.back().seek(sectionOffsets[sectionIndex(section)]);
+        }
+    }
 
-            roadPart.transformMatrix = std::array<XYZTriplet, 4>();
+    // every section has its own reader and members, so they decode independently
+    parallelFor(0, pending.size(), [&](size_t i) {
+        readSection(readers[i], pending[i]);
+    });
 
-            for (size_t k = 0; k < roadPart.transformMatrix.size(); k++) {
-                roadPart.transformMatrix[k] = readXYZTriplet(*is);
-            }
+    for (auto section : pending) {
+        loadedSections |= section;
+    }
+}
 
-            roadNet.roadParts[j] = roadPart;
-        }
+void grad_aff::Wrp::writeWrp(fs::path path) {
+    if (path.empty()) {
+        path = wrpName;
+    }
+    if (path.empty()) {
+        throw std::runtime_error("writeWrp needs a path for WRPs that weren't read from a file");
+    }
+    // skipped sections would be written empty
+    if (wrpTypeName == "OPRW") {
+        loadSections(SectionAll);
+    }
 
-        //roadNets[i] = roadNet;
-        // TODO: remove when write is needed
-        if (roadNet.nRoadParts != 0)
-            roadNets.push_back(roadNet);
+    // Write next to the target and rename at the end, the reader may still map the file that gets replaced
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    std::ofstream ofs(tmpPath, std::ios::binary);
+    if (!ofs) {
+        throw std::runtime_error("Couldn't open " + tmpPath.string());
+    }
+    WrpWriter writer(ofs, layerSizeX, layerSizeY, mapSizeX, mapSizeY, layerCellSize, appId, wrpVersion != 0 ? wrpVersion : 25);
+    writer.writeLayers(geography, cfgEnvSounds, peaks, rvmatLayerIndex);
+    writer.writeGrids(randomClutter, compressedBytes, elevation);
+    writer.writeModels(rvmats, models, classedModels);
+    writer.writeBlocks(unknownGridBlock3, unknownGridBlock4, compressedBytes2, compressedBytes3);
+    writer.writeRoadNets(roadNets);
+    writer.writeObjects(objects);
+    writer.writeMapInfo(mapInfo);
+    writer.finish(maxObjectId);
+    ofs.close();
+    if (!ofs) {
+        throw std::runtime_error("Couldn't write " + tmpPath.string());
+    }
 
+    // every section is loaded by now, release the mapping of a source that gets replaced so the rename can succeed
+    std::error_code error;
+    auto replacesSource = !wrpName.empty() && fs::equivalent(wrpName, path, error);
+    if (replacesSource) {
+        reader = BinaryReader();
+    }
+    try {
+        fs::rename(tmpPath, path);
     }
-    roadNets.shrink_to_fit();
-
-    this->objects = std::vector<Object>(sizeOfObjects / GRAD_AFF_SIZE_OF_WRPOBJECT);
-
-    for (size_t i = 0; i < objects.size(); i++) {
-        Object object;
-        object.objectId = readBytes<uint32_t>(*is);
-        // index 0 -> no model?
-        object.modelIndex = readBytes<uint32_t>(*is); // - 1?
-        object.transformMatrix = std::array<XYZTriplet, 4>();
-        for (size_t j = 0; j < object.transformMatrix.size(); j++) {
-            object.transformMatrix[j] = readXYZTriplet(*is);
+    catch (...) {
+        if (replacesSource) {
+            reader = BinaryReader::fromFile(wrpName);
         }
-        object.static0x02 = readBytes<uint32_t>(*is);
-        assert(object.static0x02 == 0x02);
-
-        objects[i] = object;
-        // TODO: Optimize this
-        this->objectIdMap.insert({ object.objectId, object });
+        throw;
     }
+    if (replacesSource) {
+        reader = BinaryReader::fromFile(path);
+    }
+}
 
-    this->mapInfo = std::vector<std::shared_ptr<MapType>>();
-    mapInfo.reserve(sizeOfMapInfo);
+void grad_aff::Wrp::writeCache(const fs::path& cachePath) {
+    loadSections(SectionElevation | SectionObjects | SectionRoadNets);
 
-    while (!is->eof()) {
-        auto infoType = readBytes<uint32_t>(*is);
+    std::error_code error;
+    auto source = !wrpName.empty() && fs::is_regular_file(wrpName, error)
+        ? WrpCacheSource::fromFile(wrpName)
+        : WrpCacheSource::fromData(reader.getBuffer());
+    WrpCache::write(*this, cachePath, source);
+}
 
-        if (std::find(this->infoTypes1.begin(), this->infoTypes1.end(), infoType) != this->infoTypes1.end()) {
-            auto mapData = std::make_shared<MapType1>();
-            mapData->mapType = 1;
-            mapData->infoType = infoType;
-            mapData->objectId = readBytes<uint32_t>(*is);
-            mapData->x = readBytes<float_t>(*is);
-            mapData->y = readBytes<float_t>(*is);
+bool grad_aff::Wrp::isLoaded(uint32_t sections) const noexcept {
+    return (loadedSections & sections) == sections;
+}
 
-            mapInfo.push_back(mapData);
-        }
-        else if (std::find(this->infoType2.begin(), this->infoType2.end(), infoType) != this->infoType2.end()) {
-            auto mapData = std::make_shared<MapType2>();
-            mapData->mapType = 2;
-            mapData->infoType = infoType;
-            mapData->objectId = readBytes<uint32_t>(*is);
-            for (size_t i = 0; i < 8; i++) {
-                mapData->bounds[i] = readBytes<float_t>(*is);
-            }
+size_t grad_aff::Wrp::sectionIndex(uint32_t section) {
+    size_t index = 0;
+    while (section > 1) {
+        section >>= 1;
+        index++;
+    }
+    return index;
+}
 
-            mapInfo.push_back(mapData);
-        }
-        else if (std::find(this->infoTypes3.begin(), this->infoTypes3.end(), infoType) != this->infoTypes3.end()) {
-            auto mapData = std::make_shared<MapType3>();
-            mapData->mapType = 3;
-            mapData->infoType = infoType;
-            mapData->color = readBytes<uint32_t>(*is);
-            mapData->indicator = readBytes<uint32_t>(*is);
-            for (size_t i = 0; i < 4; i++) {
-                mapData->floats[i] = readBytes<float_t>(*is);
+void grad_aff::Wrp::readSection(BinaryReader& reader, uint32_t section) {
+    switch (section) {
+    case SectionRandomClutter:
+        this->randomClutter = readLZOCompressed(reader, mapSize).first;
+        break;
+    case SectionCompressedBytes:
+        this->compressedBytes = readLZOCompressed(reader, mapSize).first;
+        break;
+    case SectionElevation:
+        this->elevation = readLZOCompressed<float_t>(reader, (size_t)mapSize * 4).first;
+        break;
+    case SectionCompressedBytes2:
+        this->compressedBytes2 = readLZOCompressed(reader, layerSize).first;
+        break;
+    case SectionCompressedBytes3:
+        this->compressedBytes3 = readLZOCompressed(reader, mapSize).first;
+        break;
+    case SectionRoadNets:
+        this->roadNets = std::vector<RoadNet>();// layerSize);
+
+        for (size_t i = 0; i < layerSize; i++) {
+            RoadNet roadNet;
+            roadNet.nRoadParts = readBytes<uint32_t>(reader);
+
+            roadNet.roadParts = std::vector<RoadPart>(roadNet.nRoadParts);
+
+            for (size_t j = 0; j < roadNet.nRoadParts; j++) {
+                RoadPart roadPart;
+                roadPart.nRoadPositions = readBytes<uint16_t>(reader);
+                roadPart.roadPositions = readArray<XYZTriplet>(reader, roadPart.nRoadPositions);
+                roadPart.flags = readArray<uint8_t>(reader, roadPart.nRoadPositions);
+                reader.skip(4);
+
+                roadPart.p3dModel = readZeroTerminatedString(reader);
+                roadPart.transformMatrix = readMatrix(reader);
+
+                roadNet.roadParts[j] = roadPart;
             }
 
-            mapInfo.push_back(mapData);
-        }
-        else if (std::find(this->infoTypes4.begin(), this->infoTypes4.end(), infoType) != this->infoTypes4.end()) {
-            auto mapData = std::make_shared<MapType4>();
-            mapData->mapType = 4;
-            mapData->infoType = infoType;
-            mapData->objectId = readBytes<uint32_t>(*is);
-            for (size_t i = 0; i < 8; i++) {
-                mapData->bounds[i] = readBytes<float_t>(*is);
-            }
-            for (size_t i = 0; i < 4; i++) {
-                mapData->color[i] = readBytes<uint8_t>(*is);
-            }
+            //roadNets[i] = roadNet;
+            // TODO: remove when write is needed
+            if (roadNet.nRoadParts != 0)
+                roadNets.push_back(roadNet);
 
-            mapInfo.push_back(mapData);
         }
-        else if (infoType == 34) {
-            auto mapData = std::make_shared<MapType5>();
-            mapData->mapType = 5;
-            mapData->infoType = infoType;
-            mapData->objectId = readBytes<uint32_t>(*is);
-            for (size_t i = 0; i < 4; i++) {
-                mapData->floats[i] = readBytes<float_t>(*is);
-            }
+        roadNets.shrink_to_fit();
+        this->roadGraph.build(roadNets);
+        break;
+    case SectionObjects:
+        this->objects.readObjects(reader, sizeOfObjects / GRAD_AFF_SIZE_OF_WRPOBJECT);
+        this->objectGrid.build(objects, layerCellSize, layerSizeX, layerSizeY);
+        break;
+    case SectionMapInfo:
+        readMapInfo(reader);
+        break;
+    }
+}
 
-            mapInfo.push_back(mapData);
+void grad_aff::Wrp::skipSection(uint32_t section) {
+    switch (section) {
+    case SectionRandomClutter:
+        this->randomClutter = {};
+        skipLZOCompressed(reader, mapSize);
+        break;
+    case SectionCompressedBytes:
+        this->compressedBytes = {};
+        skipLZOCompressed(reader, mapSize);
+        break;
+    case SectionElevation:
+        this->elevation = {};
+        // readLZOCompressed<float_t> doesn't consume anything for an empty map
+        if (mapSize != 0) {
+            skipLZOCompressed(reader, (size_t)mapSize * 4);
         }
-        else if (infoType == 35) {
-            auto mapData = std::make_shared<MapType35>();
-            mapData->mapType = 35;
-            mapData->infoType = infoType;
-            mapData->objectId = readBytes<uint32_t>(*is);
-            for (size_t i = 0; i < 6; i++) {
-                mapData->floats[i] = readBytes<float_t>(*is);
+        break;
+    case SectionCompressedBytes2:
+        this->compressedBytes2 = {};
+        skipLZOCompressed(reader, layerSize);
+        break;
+    case SectionCompressedBytes3:
+        this->compressedBytes3 = {};
+        skipLZOCompressed(reader, mapSize);
+        break;
+    case SectionRoadNets:
+        this->roadNets = {};
+        this->roadGraph.clear();
+        for (size_t i = 0; i < layerSize; i++) {
+            auto nRoadParts = readBytes<uint32_t>(reader);
+            for (size_t j = 0; j < nRoadParts; j++) {
+                auto nRoadPositions = readBytes<uint16_t>(reader);
+                // positions, flags and 4 unknown bytes
+                reader.skip((size_t)nRoadPositions * (sizeof(XYZTriplet) + 1) + 4);
+                auto rest = reader.getRemaining();
+                reader.skip(std::find(rest.begin(), rest.end(), 0) - rest.begin() + 1);
+                reader.skip(sizeof(TransformMatrix));
             }
-            mapData->unknown = readBytes<uint8_t>(*is);
+        }
+        break;
+    case SectionObjects:
+        this->objects.clear();
+        this->objectGrid.clear();
+        reader.skip(sizeOfObjects / GRAD_AFF_SIZE_OF_WRPOBJECT * GRAD_AFF_SIZE_OF_WRPOBJECT);
+        break;
+    case SectionMapInfo:
+        this->mapInfo.clear();
+        reader.skip(sizeOfMapInfo);
+        break;
+    }
+}
 
-            mapInfo.push_back(mapData);
+void grad_aff::Wrp::readMapInfo(BinaryReader& reader) {
+    // record kind of every infoType, 0 for unknown ones
+    enum Kind : uint8_t { Unknown, Kind1, Kind2, Kind3, Kind4, Kind5, Kind35 };
+    std::array<Kind, 256> kinds = {};
+    for (auto infoType : infoTypes1) kinds[infoType] = Kind1;
+    for (auto infoType : infoType2) kinds[infoType] = Kind2;
+    for (auto infoType : infoTypes3) kinds[infoType] = Kind3;
+    for (auto infoType : infoTypes4) kinds[infoType] = Kind4;
+    kinds[34] = Kind5;
+    kinds[35] = Kind35;
+
+    auto readKind = [&]() {
+        auto infoType = readBytes<uint32_t>(reader);
+        auto kind = infoType < kinds.size() ? kinds[infoType] : Unknown;
+        if (kind == Unknown) {
+            std::stringstream errorString;
+            errorString << "Unkown infoType " << infoType << " encounterd at " << reader.tell() << " in " << this->wrpName << ". Please report this error at: https://github.com/gruppe-adler/grad_aff/issues";
+            throw std::runtime_error(errorString.str());
         }
-        else {
+        return std::make_pair(infoType, kind);
+    };
+
+    auto sectionEnd = reader.tell() + (size_t)sizeOfMapInfo;
+    if (sectionEnd > reader.size()) {
+        throw std::runtime_error("Map info runs past the end of " + this->wrpName);
+    }
+    // bytes after the infoType
+    const std::array<size_t, 7> recordSizes = { 0, 12, 36, 24, 40, 20, 29 };
+    auto requireInSection = [&](size_t recordStart, size_t size) {
+        if (size > sectionEnd - reader.tell()) {
             std::stringstream errorString;
-            errorString << "Unkown infoType " << infoType << " encounterd at " << is->tellg() << " in " << this->wrpName << ". Please report this error at: https://github.com/gruppe-adler/grad_aff/issues";
+            errorString << "Map info record at " << recordStart << " crosses the end of the section in " << this->wrpName;
             throw std::runtime_error(errorString.str());
         }
+    };
+
+    this->mapInfo = {};
+    // only the order is reserved, the smallest record is 16 bytes so the section size bounds the record count.
+    // The per type arrays grow, counting them would take a second pass over the records
+    mapInfo.order.reserve(sizeOfMapInfo / 16);
+
+    while (reader.tell() < sectionEnd) {
+        auto recordStart = reader.tell();
+        requireInSection(recordStart, sizeof(uint32_t));
+        auto [infoType, kind] = readKind();
+        requireInSection(recordStart, recordSizes[kind]);
+
+        switch (kind) {
+        case Kind1: {
+            MapType1 mapData;
+            mapData.mapType = 1;
+            mapData.infoType = infoType;
+            mapData.objectId = readBytes<uint32_t>(reader);
+            mapData.x = readBytes<float_t>(reader);
+            mapData.y = readBytes<float_t>(reader);
+
+            mapInfo.order.emplace_back(1, (uint32_t)mapInfo.mapTypes1.size());
+            mapInfo.mapTypes1.push_back(mapData);
+            break;
+        }
+        case Kind2: {
+            MapType2 mapData;
+            mapData.mapType = 2;
+            mapData.infoType = infoType;
+            mapData.objectId = readBytes<uint32_t>(reader);
+            mapData.bounds = reader.read<std::array<float_t, 8>>();
+
+            mapInfo.order.emplace_back(2, (uint32_t)mapInfo.mapTypes2.size());
+            mapInfo.mapTypes2.push_back(mapData);
+            break;
+        }
+        case Kind3: {
+            MapType3 mapData;
+            mapData.mapType = 3;
+            mapData.infoType = infoType;
+            mapData.color = readBytes<uint32_t>(reader);
+            mapData.indicator = readBytes<uint32_t>(reader);
+            mapData.floats = reader.read<std::array<float_t, 4>>();
+
+            mapInfo.order.emplace_back(3, (uint32_t)mapInfo.mapTypes3.size());
+            mapInfo.mapTypes3.push_back(mapData);
+            break;
+        }
+        case Kind4: {
+            MapType4 mapData;
+            mapData.mapType = 4;
+            mapData.infoType = infoType;
+            mapData.objectId = readBytes<uint32_t>(reader);
+            mapData.bounds = reader.read<std::array<float_t, 8>>();
+            mapData.color = reader.read<std::array<uint8_t, 4>>();
+
+            mapInfo.order.emplace_back(4, (uint32_t)mapInfo.mapTypes4.size());
+            mapInfo.mapTypes4.push_back(mapData);
+            break;
+        }
+        case Kind5: {
+            MapType5 mapData;
+            mapData.mapType = 5;
+            mapData.infoType = infoType;
+            mapData.objectId = readBytes<uint32_t>(reader);
+            mapData.floats = reader.read<std::array<float_t, 4>>();
+
+            mapInfo.order.emplace_back(5, (uint32_t)mapInfo.mapTypes5.size());
+            mapInfo.mapTypes5.push_back(mapData);
+            break;
+        }
+        case Kind35: {
+            MapType35 mapData;
+            mapData.mapType = 35;
+            mapData.infoType = infoType;
+            mapData.objectId = readBytes<uint32_t>(reader);
+            mapData.floats = reader.read<std::array<float_t, 6>>();
+            mapData.unknown = readBytes<uint8_t>(reader);
+
+            mapInfo.order.emplace_back(35, (uint32_t)mapInfo.mapTypes35.size());
+            mapInfo.mapTypes35.push_back(mapData);
+            break;
+        }
+        case Unknown:
+            // readKind already threw
+            break;
+        }
     }
-    mapInfo.shrink_to_fit();
-    
 }
@@ -3,6 +3,15 @@
 #include <catch2/catch_all.hpp>
 
 #include "grad_aff/paa/paa.h"
+#include "grad_aff/paa/DxtDecoder.h"
+#include "grad_aff/paa/DxtEncoder.h"
+#include "grad_aff/Parallel.h"
+
+#include <squish.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <random>
 
 TEST_CASE("test 2048x128", "[read-write-2048x128]") {
     grad_aff::Paa test_paa_obj;
@@ -68,6 +77,122 @@ TEST_CASE("read/write DXT5", "[read-write-dxt5]") {
     REQUIRE_NOTHROW(test_paa_obj_2.readPaa("Bundle_Text_out.paa"));
 }
 
+TEST_CASE("lazy dxt decode", "[lazy-dxt-decode]") {
+    grad_aff::Paa eager_paa_obj;
+    REQUIRE_NOTHROW(eager_paa_obj.readPaa("DXT1_LZO_Test.paa"));
+
+    grad_aff::Paa lazy_paa_obj;
+    lazy_paa_obj.lazyDecode = true;
+    REQUIRE_NOTHROW(lazy_paa_obj.readPaa("DXT1_LZO_Test.paa"));
+    REQUIRE_FALSE(lazy_paa_obj.mipMaps[0].decoded);
+    REQUIRE(lazy_paa_obj.getRawPixelDataAt(5, 6, 1) == eager_paa_obj.getRawPixelDataAt(5, 6, 1));
+    REQUIRE_FALSE(lazy_paa_obj.mipMaps[1].decoded);
+    REQUIRE(lazy_paa_obj.getRawPixelData(1) == eager_paa_obj.getRawPixelData(1));
+    REQUIRE_FALSE(lazy_paa_obj.mipMaps[0].decoded);
+
+    // untouched levels are copied as they are
+    auto first = lazy_paa_obj.writePaa(grad_aff::Paa::TypeOfPaX::DXT1);
+    grad_aff::Paa reread_paa_obj;
+    reread_paa_obj.lazyDecode = true;
+    reread_paa_obj.readPaa(first);
+    REQUIRE(reread_paa_obj.writePaa(grad_aff::Paa::TypeOfPaX::DXT1) == first);
+}
+
+TEST_CASE("dxt decoder matches squish", "[dxt-decoder]") {
+    std::mt19937 random(42);
+    for (auto flags : { squish::kDxt1, squish::kDxt5 }) {
+        // 6x10 has partial border blocks
+        for (auto [width, height] : { std::pair<int, int>{ 6, 10 }, { 512, 256 } }) {
+            size_t bytesPerBlock = flags == squish::kDxt1 ? 8 : 16;
+            std::vector<uint8_t> blocks(((width + 3) / 4) * ((height + 3) / 4) * bytesPerBlock);
+            for (auto& byte : blocks) {
+                byte = (uint8_t)random();
+            }
+
+            std::vector<uint8_t> expected((size_t)width * height * 4);
+            std::vector<uint8_t> decoded((size_t)width * height * 4);
+            squish::DecompressImage(expected.data(), width, height, blocks.data(), flags);
+            if (flags == squish::kDxt1) {
+                grad_aff::decodeBc1(blocks.data(), width, height, decoded.data());
+            }
+            else {
+                grad_aff::decodeBc3(blocks.data(), width, height, decoded.data());
+            }
+            REQUIRE(decoded == expected);
+        }
+    }
+}
+
+TEST_CASE("fast dxt encoder", "[dxt-encoder]") {
+    // smooth gradients with a little noise, alpha steps in the lower half
+    std::mt19937 random(7);
+    for (auto [width, height] : { std::pair<uint32_t, uint32_t>{ 6, 10 }, { 256, 256 } }) {
+        std::vector<uint8_t> rgba((size_t)width * height * 4);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                auto pixel = rgba.data() + ((size_t)y * width + x) * 4;
+                pixel[0] = (uint8_t)((x + y) * 255 / (width + height));
+                pixel[1] = (uint8_t)(255 - pixel[0]);
+                pixel[2] = (uint8_t)(128 + random() % 8);
+                pixel[3] = y < height / 2 ? 255 : (uint8_t)((x / 4) % 2 == 0 ? 0 : 200);
+            }
+        }
+
+        std::vector<uint8_t> blocks(((width + 3) / 4) * ((height + 3) / 4) * 16);
+        std::vector<uint8_t> decoded(rgba.size());
+        auto meanError = [&](int channels) {
+            double sum = 0;
+            for (size_t i = 0; i < rgba.size(); i++) {
+                if ((int)(i % 4) < channels) {
+                    sum += std::abs((int)rgba[i] - (int)decoded[i]);
+                }
+            }
+            return sum / (rgba.size() / 4 * channels);
+        };
+
+        grad_aff::encodeBc3(rgba.data(), width, height, blocks.data());
+        grad_aff::decodeBc3(blocks.data(), width, height, decoded.data());
+        REQUIRE(meanError(4) < 6);
+
+        grad_aff::encodeBc1(rgba.data(), width, height, blocks.data());
+        grad_aff::decodeBc1(blocks.data(), width, height, decoded.data());
+        for (size_t i = 3; i < rgba.size(); i += 4) {
+            REQUIRE((decoded[i] == 255) == (rgba[i] >= 128));
+        }
+        // transparent pixels decode to black
+        for (size_t i = 0; i < rgba.size(); i += 4) {
+            if (rgba[i + 3] < 128) {
+                rgba[i] = rgba[i + 1] = rgba[i + 2] = 0;
+            }
+        }
+        REQUIRE(meanError(3) < 6);
+    }
+
+    grad_aff::Paa paa_obj;
+    REQUIRE_NOTHROW(paa_obj.readPaa("DXT1_LZO_Test.paa"));
+    auto reference = paa_obj.getRawPixelData(0);
+    auto data = paa_obj.writePaa(grad_aff::Paa::TypeOfPaX::DXT1, grad_aff::Paa::DxtQuality::Fast);
+    grad_aff::Paa reread_paa_obj;
+    REQUIRE_NOTHROW(reread_paa_obj.readPaa(data));
+    REQUIRE(reread_paa_obj.getRawPixelData(0).size() == reference.size());
+}
+
+TEST_CASE("nested parallel for", "[parallel-for]") {
+    // batch of images, each compressed in parallel itself
+    std::atomic<size_t> sum(0);
+    grad_aff::parallelFor(0, 64, [&sum](size_t i) {
+        grad_aff::parallelFor(0, 64, [&sum, i](size_t j) {
+            sum += i * 64 + j;
+        });
+    });
+    REQUIRE(sum == 4096 * 4095 / 2);
+    REQUIRE_THROWS_AS(grad_aff::parallelFor(0, 100, [](size_t i) {
+        if (i == 57) {
+            throw std::runtime_error("failed");
+        }
+    }), std::runtime_error);
+}
+
 TEST_CASE("empty paa read", "[empty-paa-read]") {
     grad_aff::Paa test_paa_obj;
     REQUIRE_THROWS_WITH(test_paa_obj.readPaa(""), "Invalid file/magic number");
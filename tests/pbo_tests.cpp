@@ -24,17 +24,89 @@ TEST_CASE("extract single file", "[single-extract-pbo]") {
     testPbo.extractSingleFile("data\\env_cloth_neutral_co.paa", "unpack3", false);
 }
 
+TEST_CASE("parallel extract pbo", "[parallel-extract-pbo]") {
+    grad_aff::Pbo testPbo("A3.pbo");
+    REQUIRE_NOTHROW(testPbo.readPbo(false));
+    REQUIRE_NOTHROW(testPbo.extractPbo("unpack_parallel", 1024 * 1024));
+    REQUIRE(fs::exists("unpack_parallel/config.bin"));
+}
+
 TEST_CASE("prefix read pbo", "[prefix-read-pbo]") {
     grad_aff::Pbo testPbo("map_altis_data_layers_00_01.pbo");
     REQUIRE(testPbo.getEntryData("a3\\map_altis\\data\\layers\\00_01\\m_003_037_lca.paa").size() > 0);
 }
 
+TEST_CASE("mapped pbo view", "[mapped-view-pbo]") {
+    grad_aff::Pbo mappedPbo("A3.pbo");
+    REQUIRE_NOTHROW(mappedPbo.readPbo(false));
+    auto view = mappedPbo.getEntryView("data\\env_co.paa");
+    auto data = mappedPbo.getEntryData("data\\env_co.paa");
+    REQUIRE(view.size() > 0);
+    REQUIRE(std::equal(view.begin(), view.end(), data.begin(), data.end()));
+}
+
 TEST_CASE("meh", "[meh]") {
     grad_aff::Pbo mehPbo("grad_meh_main.pbo");
     REQUIRE_NOTHROW(mehPbo.readPbo());
     REQUIRE_NOTHROW(mehPbo.writePbo(""));
 }
 
+TEST_CASE("pack dir", "[pack-dir-pbo]") {
+    grad_aff::Pbo testPbo("A3.pbo");
+    REQUIRE_NOTHROW(testPbo.extractPbo("unpack_pack_dir"));
+
+    grad_aff::Pbo packedPbo(std::vector<uint8_t>{}, "A3_packed");
+    REQUIRE_NOTHROW(packedPbo.addDir("unpack_pack_dir"));
+    REQUIRE_NOTHROW(packedPbo.writePbo(""));
+
+    grad_aff::Pbo readPbo("A3_packed.pbo");
+    REQUIRE_NOTHROW(readPbo.readPbo());
+    REQUIRE(readPbo.hasEntry("config.bin"));
+}
+
+TEST_CASE("repack onto itself", "[repack-self-pbo]") {
+    fs::copy_file("A3.pbo", "A3_repack.pbo", fs::copy_options::overwrite_existing);
+    grad_aff::Pbo testPbo("A3.pbo");
+
+    grad_aff::Pbo repackPbo("A3_repack.pbo");
+    REQUIRE_NOTHROW(repackPbo.readPbo(false));
+    REQUIRE_NOTHROW(repackPbo.writePbo(""));
+    REQUIRE(repackPbo.getEntryData("config.bin") == testPbo.getEntryData("config.bin"));
+
+    grad_aff::Pbo readPbo("A3_repack.pbo");
+    REQUIRE(readPbo.getEntryData("config.bin") == testPbo.getEntryData("config.bin"));
+}
+
+TEST_CASE("extract added file", "[extract-added-pbo]") {
+    grad_aff::Pbo testPbo("A3.pbo");
+    REQUIRE_NOTHROW(testPbo.extractSingleFile("config.bin", "extract_added_source", false));
+
+    grad_aff::Pbo addedPbo(std::vector<uint8_t>{}, "added");
+    REQUIRE_NOTHROW(addedPbo.addFile("extract_added_source/config.bin", "data/config.bin"));
+    REQUIRE_NOTHROW(addedPbo.extractPbo("extract_added"));
+    REQUIRE(fs::file_size("extract_added/data/config.bin") == fs::file_size("extract_added_source/config.bin"));
+
+    // single entries come from the source file as well
+    REQUIRE_NOTHROW(addedPbo.extractSingleFile("data/config.bin", "extract_added_single"));
+    REQUIRE(fs::file_size("extract_added_single/data/config.bin") == fs::file_size("extract_added_source/config.bin"));
+    // lookups go through the prefix
+    addedPbo.productEntries["prefix"] = "added";
+    REQUIRE(addedPbo.getEntryData("added\\data\\config.bin") == testPbo.getEntryData("config.bin"));
+}
+
+TEST_CASE("pack dir compressed", "[pack-dir-compressed-pbo]") {
+    grad_aff::Pbo testPbo("A3.pbo");
+    REQUIRE_NOTHROW(testPbo.extractPbo("unpack_pack_compressed"));
+
+    grad_aff::Pbo packedPbo(std::vector<uint8_t>{}, "A3_packed_compressed");
+    REQUIRE_NOTHROW(packedPbo.addDir("unpack_pack_compressed"));
+    REQUIRE_NOTHROW(packedPbo.writePbo("", true));
+
+    grad_aff::Pbo readPbo("A3_packed_compressed.pbo");
+    REQUIRE_NOTHROW(readPbo.readPbo());
+    REQUIRE(readPbo.getEntryData("config.bin") == testPbo.getEntryData("config.bin"));
+}
+
 TEST_CASE("Test has entry", "[has-entry]") {
     grad_aff::Pbo mehPbo("A3.pbo");
     REQUIRE_NOTHROW(mehPbo.readPbo());
@@ -46,10 +118,48 @@ TEST_CASE("Test has entry", "[has-entry]") {
 }
 
 
+TEST_CASE("repeated entry name", "[repeated-entry-pbo]") {
+    std::vector<uint8_t> data = { 0, 's', 'r', 'e', 'V' };
+    data.insert(data.end(), 16, 0);
+    for (auto c : std::string("prefix\0x\0", 9)) {
+        data.push_back((uint8_t)c);
+    }
+    data.push_back(0);
+    // a, b and a again, the second a replaces the first but its data comes last
+    for (auto [name, size] : { std::pair<char, uint8_t>{ 'a', 3 }, { 'b', 2 }, { 'a', 4 } }) {
+        data.insert(data.end(), { (uint8_t)name, 0 });
+        data.insert(data.end(), 16, 0);
+        data.insert(data.end(), { size, 0, 0, 0 });
+    }
+    data.insert(data.end(), 21, 0);
+    for (auto c : std::string("AAABBaaaa")) {
+        data.push_back((uint8_t)c);
+    }
+    data.insert(data.end(), 21, 0);
+
+    grad_aff::Pbo pbo(data, "repeated");
+    REQUIRE_NOTHROW(pbo.readPbo(false));
+    REQUIRE(pbo.getEntryData("a") == std::vector<uint8_t>{ 'a', 'a', 'a', 'a' });
+    REQUIRE(pbo.getEntryData("b") == std::vector<uint8_t>{ 'B', 'B' });
+}
+
 #ifdef GRAD_AFF_USE_OPENSSL
 TEST_CASE("Hash Test", "[hash-test]") {
     grad_aff::Pbo mehPbo("map_altis_data_layers_00_01.pbo");
     REQUIRE_NOTHROW(mehPbo.readPbo());
     REQUIRE(mehPbo.checkHash());
 }
+
+TEST_CASE("Hash header only", "[hash-header-only]") {
+    grad_aff::Pbo mehPbo("map_altis_data_layers_00_01.pbo");
+    REQUIRE(mehPbo.checkHash());
+    REQUIRE(mehPbo.entries.begin()->second->data.size() == 0);
+}
+
+TEST_CASE("Hash batch test", "[hash-batch]") {
+    auto results = grad_aff::Pbo::checkHashes({ "map_altis_data_layers_00_01.pbo", "does_not_exist.pbo" });
+    REQUIRE(results.size() == 2);
+    REQUIRE(results[0]);
+    REQUIRE_FALSE(results[1]);
+}
 #endif
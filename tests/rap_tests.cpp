@@ -25,6 +25,49 @@ TEST_CASE("lzss test", "[lzss-test]") {
     test_rap_obj2.readRap();
 }
 
+TEST_CASE("lzss buffer round trip", "[lzss-buffer-round-trip]") {
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 100000; i++) {
+        data.push_back((uint8_t)(i % 251 ^ (i / 977)));
+    }
+
+    std::vector<uint8_t> compressed;
+    grad_aff::writeLzss(data, compressed);
+    REQUIRE(compressed.size() < data.size());
+
+    std::vector<uint8_t> sized;
+    REQUIRE(grad_aff::readLzss(grad_aff::ByteSpan(compressed), sized, data.size(), false) == compressed.size());
+    REQUIRE(sized == data);
+
+    std::vector<uint8_t> unsized;
+    REQUIRE(grad_aff::readLzss(compressed, unsized) == compressed.size());
+    REQUIRE(unsized == data);
+}
+
+TEST_CASE("binary reader", "[binary-reader]") {
+    grad_aff::BinaryReader reader(std::vector<uint8_t>{ 0x2a, 0x00, 0x00, 0x00, 'a', 'b', 0x00, 0x81, 0x02, 0xff });
+    REQUIRE(grad_aff::readBytes<uint32_t>(reader) == 42);
+    REQUIRE(grad_aff::readZeroTerminatedString(reader) == "ab");
+    REQUIRE(grad_aff::readCompressedInteger(reader) == 0x101);
+    REQUIRE(reader.remaining() == 1);
+    REQUIRE_THROWS_AS(grad_aff::readBytes<uint16_t>(reader), std::out_of_range);
+    REQUIRE(grad_aff::readBytes<uint8_t>(reader) == 0xff);
+    REQUIRE(reader.eof());
+}
+
+TEST_CASE("binary reader array", "[binary-reader-array]") {
+    std::vector<float_t> values = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+    std::vector<uint8_t> data(values.size() * sizeof(float_t));
+    std::memcpy(data.data(), values.data(), data.size());
+
+    grad_aff::BinaryReader reader(data);
+    auto triplets = grad_aff::readArray<XYZTriplet>(reader, 2);
+    REQUIRE(triplets.size() == 2);
+    REQUIRE(triplets[1][2] == 6.0f);
+    REQUIRE(reader.eof());
+    REQUIRE_THROWS_AS(grad_aff::readArray<uint32_t>(reader, 1), std::out_of_range);
+}
+
 TEST_CASE("parse enoch roadslib", "[parse-enoch-roadslib]") {
     grad_aff::Rap test_rap_obj;
     test_rap_obj.parseConfig("roadslib_enoch.cfg");
@@ -58,3 +58,221 @@ TEST_CASE("read Altis in memory", "[read-altis-memory]") {
     test_wrp_obj.readWrp();
     
 }
+
+TEST_CASE("object table lookup", "[object-table-lookup]") {
+    grad_aff::ObjectTable objects;
+    for (uint32_t id : { 5u, 7u, 3u, 9u }) {
+        Object object;
+        object.objectId = id;
+        object.modelIndex = id * 10;
+        object.transformMatrix[3] = { (float_t)id, 0.0f, 1.0f };
+        objects.addObject(object);
+    }
+
+    REQUIRE(objects.size() == 4);
+    REQUIRE(objects.findObject(3) == 2);
+    REQUIRE(objects.findObject(9) == 3);
+    REQUIRE(objects.findObject(4) == grad_aff::ObjectTable::npos);
+    REQUIRE(objects.getObject(objects.findObject(7)).modelIndex == 70);
+    REQUIRE(objects.getPositions()[0][0] == 5.0f);
+}
+
+TEST_CASE("object grid queries", "[object-grid-queries]") {
+    grad_aff::ObjectTable objects;
+    for (uint32_t i = 0; i < 100; i++) {
+        Object object;
+        object.objectId = i;
+        object.transformMatrix[3] = { (float_t)(i % 10) * 10.0f + 5.0f, 0.0f, (float_t)(i / 10) * 10.0f + 5.0f };
+        objects.addObject(object);
+    }
+
+    grad_aff::ObjectGrid grid;
+    grid.build(objects, 25.0f, 4, 4);
+
+    auto rect = grid.queryRect(0.0f, 0.0f, 20.0f, 20.0f);
+    std::sort(rect.begin(), rect.end());
+    REQUIRE(rect == std::vector<uint32_t>{ 0, 1, 10, 11 });
+
+    REQUIRE(grid.queryRadius(55.0f, 55.0f, 10.0f).size() == 5);
+
+    auto nearest = grid.queryNearest(54.0f, 56.0f, 3);
+    REQUIRE(nearest.size() == 3);
+    REQUIRE(nearest[0] == 55);
+    REQUIRE(grid.queryNearest(-1000.0f, -1000.0f, 1) == std::vector<uint32_t>{ 0 });
+}
+
+TEST_CASE("read wrp sections", "[read-wrp-sections]") {
+    grad_aff::Wrp full("Tembelan.wrp");
+    REQUIRE_NOTHROW(full.readWrp());
+
+    grad_aff::Wrp lazy("Tembelan.wrp");
+    REQUIRE_NOTHROW(lazy.readWrp(grad_aff::Wrp::SectionElevation | grad_aff::Wrp::SectionObjects));
+    REQUIRE(lazy.elevation == full.elevation);
+    REQUIRE(lazy.objects.getObjectIds() == full.objects.getObjectIds());
+    REQUIRE(lazy.models == full.models);
+    REQUIRE(lazy.mapInfo.empty());
+    REQUIRE_FALSE(lazy.isLoaded(grad_aff::Wrp::SectionMapInfo));
+
+    lazy.loadSections(grad_aff::Wrp::SectionMapInfo | grad_aff::Wrp::SectionRoadNets);
+    REQUIRE(lazy.mapInfo.size() == full.mapInfo.size());
+    REQUIRE(lazy.roadNets.size() == full.roadNets.size());
+    REQUIRE(lazy.isLoaded(grad_aff::Wrp::SectionMapInfo | grad_aff::Wrp::SectionElevation));
+}
+
+TEST_CASE("grid block lookup", "[grid-block-lookup]") {
+    grad_aff::GridBlockTree tree;
+    tree.leafSize = 4;
+    tree.levels = 2;
+    // root: child 5 is a packet, the other 15 children are leaves 0..14
+    tree.nodes.resize(2);
+    for (uint32_t i = 0, leaf = 0; i < 16; i++) {
+        tree.nodes[0][i] = i == 5 ? 1 : grad_aff::GridBlockTree::leafFlag | leaf++;
+    }
+    for (uint32_t i = 0; i < 16; i++) {
+        tree.nodes[1][i] = grad_aff::GridBlockTree::leafFlag | (15 + i);
+    }
+    for (uint32_t leaf = 0; leaf < 31; leaf++) {
+        tree.leafData.insert(tree.leafData.end(), { (uint8_t)leaf, 0, 0, 0 });
+    }
+
+    REQUIRE(tree.leafCount() == 31);
+    REQUIRE(tree.getValue(0, 0) == 0);
+    REQUIRE(tree.getValue(15, 15) == 14);
+    // x 4..7, y 4..7 is the nested packet
+    REQUIRE(tree.getValue(4, 4) == 15);
+    REQUIRE(tree.getValue(7, 6) == 15 + 3 + 2 * 4);
+    REQUIRE(tree.getLeaf(16, 0).empty());
+}
+
+TEST_CASE("heightmap sampling", "[heightmap-sampling]") {
+    // plane rising 1m per meter in x, a 100m spike at grid point 4/4
+    std::vector<float_t> heights(8 * 8);
+    for (uint32_t y = 0; y < 8; y++) {
+        for (uint32_t x = 0; x < 8; x++) {
+            heights[x + y * 8] = x * 10.0f;
+        }
+    }
+    heights[4 + 4 * 8] = 100.0f;
+    grad_aff::Heightmap heightmap(heights, 8, 8, 10.0f);
+
+    REQUIRE(heightmap.sampleHeight(15.0f, 62.0f) == Catch::Approx(15.0f));
+    REQUIRE(heightmap.sampleHeight(-50.0f, 0.0f) == Catch::Approx(0.0f));
+    REQUIRE(heightmap.sampleNormal(15.0f, 62.0f)[0] == Catch::Approx(-std::sqrt(0.5f)));
+
+    std::vector<float_t> x = { 15.0f, 40.0f, 41.0f, 5.0f, 70.0f };
+    std::vector<float_t> y = { 62.0f, 40.0f, 40.0f, 5.0f, 70.0f };
+    std::vector<float_t> sampled(x.size());
+    heightmap.sampleHeights(x.data(), y.data(), sampled.data(), x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        REQUIRE(sampled[i] == heightmap.sampleHeight(x[i], y[i]));
+    }
+
+    auto range = heightmap.getHeightRange(0.0f, 0.0f, 70.0f, 70.0f);
+    REQUIRE(range.first == 0.0f);
+    REQUIRE(range.second == 100.0f);
+
+    REQUIRE_FALSE(heightmap.lineOfSight({ 0.0f, 80.0f, 40.0f }, { 70.0f, 80.0f, 40.0f }));
+    REQUIRE(heightmap.lineOfSight({ 0.0f, 80.0f, 10.0f }, { 70.0f, 80.0f, 10.0f }));
+}
+
+TEST_CASE("map info by type", "[map-info-by-type]") {
+    grad_aff::Wrp test_wrp_obj("Tembelan.wrp");
+    REQUIRE_NOTHROW(test_wrp_obj.readWrp(grad_aff::Wrp::SectionMapInfo));
+
+    const auto& mapInfo = test_wrp_obj.mapInfo;
+    REQUIRE(mapInfo.size() == mapInfo.mapTypes1.size() + mapInfo.mapTypes2.size() + mapInfo.mapTypes3.size()
+        + mapInfo.mapTypes4.size() + mapInfo.mapTypes5.size() + mapInfo.mapTypes35.size());
+    for (size_t i = 0; i < mapInfo.size(); i++) {
+        REQUIRE(mapInfo.at(i).mapType == mapInfo.order[i].first);
+    }
+}
+
+TEST_CASE("road graph", "[road-graph]") {
+    // two parts meeting at 10/0 with a small gap, a third part on its own
+    RoadNet roadNet;
+    for (auto positions : { std::vector<XYZTriplet>{ { 0, 0, 0 }, { 10, 0, 0 } },
+                            std::vector<XYZTriplet>{ { 10.2f, 0, 0 }, { 10, 0, 10 }, { 20, 0, 10 } },
+                            std::vector<XYZTriplet>{ { 100, 0, 100 }, { 110, 0, 100 } } }) {
+        RoadPart roadPart;
+        roadPart.nRoadPositions = (uint16_t)positions.size();
+        roadPart.roadPositions = positions;
+        roadNet.roadParts.push_back(roadPart);
+    }
+    roadNet.nRoadParts = 3;
+
+    grad_aff::RoadGraph roadGraph;
+    roadGraph.build({ roadNet });
+    REQUIRE(roadGraph.getNodeCount() == 6);
+    REQUIRE(roadGraph.getSegmentCount() == 4);
+
+    grad_aff::RoadHit hit;
+    REQUIRE(roadGraph.nearestRoad(5, 3, hit));
+    REQUIRE(hit.distance == Catch::Approx(3));
+    REQUIRE(roadGraph.getSegmentParts()[hit.segment] == 0);
+
+    std::vector<uint32_t> path;
+    REQUIRE(roadGraph.shortestPath(roadGraph.nearestNode(-1, 0), roadGraph.nearestNode(21, 10), path) == Catch::Approx(30));
+    REQUIRE(path.size() == 4);
+    REQUIRE(roadGraph.shortestPath(roadGraph.nearestNode(0, 0), roadGraph.nearestNode(100, 100), path) == INFINITY);
+    REQUIRE(path.empty());
+}
+
+TEST_CASE("write wrp", "[write-wrp]") {
+    {
+        std::ofstream ofs("written.wrp", std::ios::binary);
+        grad_aff::WrpWriter writer(ofs, 4, 4, 8, 8, 50);
+        writer.writeLayers({}, {}, {}, {});
+        std::vector<float_t> elevation(64, 12.5f);
+        writer.writeGrids({}, {}, elevation);
+        writer.writeModels({}, { "a.p3d" }, {});
+        writer.writeBlocks({}, {}, {}, {});
+        writer.writeRoadNets({});
+
+        // objects in two batches
+        std::vector<Object> objects(100);
+        for (uint32_t i = 0; i < objects.size(); i++) {
+            objects[i].objectId = i;
+            objects[i].transformMatrix[3] = { (float_t)i, 0, (float_t)i };
+        }
+        writer.writeObjects(objects.data(), 50);
+        writer.writeObjects(objects.begin() + 50, objects.end());
+        REQUIRE_THROWS(writer.writeRoadNets({}));
+        writer.finish();
+    }
+
+    grad_aff::Wrp test_wrp_obj("written.wrp");
+    REQUIRE_NOTHROW(test_wrp_obj.readWrp());
+    REQUIRE(test_wrp_obj.elevation[63] == 12.5f);
+    REQUIRE(test_wrp_obj.objects.size() == 100);
+    REQUIRE(test_wrp_obj.objects.getPositions()[99][0] == 99);
+    REQUIRE(test_wrp_obj.maxObjectId == 99);
+
+    // over the file it's mapped from
+    REQUIRE_NOTHROW(test_wrp_obj.writeWrp());
+    grad_aff::Wrp rewritten("written.wrp");
+    REQUIRE_NOTHROW(rewritten.readWrp());
+    REQUIRE(rewritten.objects.size() == 100);
+
+    // a WRP read from memory has no file to fall back to
+    std::ifstream ifs("written.wrp", std::ios::binary);
+    grad_aff::Wrp buffered(std::vector<uint8_t>(std::istreambuf_iterator<char>(ifs), {}));
+    REQUIRE_NOTHROW(buffered.readWrp());
+    REQUIRE_THROWS(buffered.writeWrp());
+}
+
+TEST_CASE("wrp cache", "[wrp-cache]") {
+    grad_aff::Wrp test_wrp_obj("Tembelan.wrp");
+    REQUIRE_NOTHROW(test_wrp_obj.readWrp());
+    REQUIRE_NOTHROW(test_wrp_obj.writeCache("Tembelan.wrpcache"));
+
+    grad_aff::WrpCache cache("Tembelan.wrpcache");
+    REQUIRE(cache.isValidFor("Tembelan.wrp", true));
+    REQUIRE(cache.getElevation().size() == test_wrp_obj.elevation.size());
+    REQUIRE(cache.getObjectCount() == test_wrp_obj.objects.size());
+    REQUIRE(cache.getModelCount() == test_wrp_obj.models.size());
+    if (!test_wrp_obj.models.empty()) {
+        REQUIRE(cache.getModel(0) == test_wrp_obj.models[0]);
+    }
+    REQUIRE(cache.getRoadSegmentNodes().size() == test_wrp_obj.roadGraph.getSegmentCount());
+    REQUIRE_FALSE(cache.isValidFor("takistan.wrp"));
+}